@@ -68,93 +68,94 @@ void wtAudioEngine::Shutdown()
 }
 
 
-void wtAudioEngine::EncodeSamples( wtSampleQueue& soundQueue )
+void wtAudioEngine::EncodeSamples( wtAudioRing& ring )
 {
-	bool buffersFull = false;
-	int32_t* destIx = &soundBufferBytesCnt[ currentSndBufferIx ];
-	for( uint32_t sampleIx = 0; sampleIx < soundQueue.GetSampleCnt(); ++sampleIx )
+	if ( pSourceVoice == nullptr )
+		return;
+
+	// The emulator writes at its own pace, after a stall drop the oldest audio to get back to the target latency
+	const uint32_t targetSamples = static_cast<uint32_t>( ( ClampLatencyMs( targetLatencyMs ) * FreqHz ) / 1000 );
+	ring.Trim( targetSamples );
+
+	pSourceVoice->GetState( &audioState, XAUDIO2_VOICE_NOSAMPLESPLAYED );
+
+	uint32_t queuedSubmits = audioState.BuffersQueued;
+	while ( ( queuedSubmits < MinQueuedSubmits ) && ( soundBufferState[ currentSndBufferIx ] == SOUND_STATE_EMPTY ) )
 	{
-		assert( soundBufferState[ currentSndBufferIx ] != SOUND_STATE_SUBMITTED );
-
-		float rawSample = soundQueue.Peek( sampleIx );
-		int16_t encodedSample = static_cast<int16_t>( rawSample );
-		soundDataBuffer[ currentSndBufferIx ][ ( *destIx )++ ] = encodedSample & 0xFF;
-		soundDataBuffer[ currentSndBufferIx ][ ( *destIx )++ ] = ( encodedSample >> 8 ) & 0xFF;
-		
-		int32_t target = static_cast<int32_t>( BytesPerSubmit - 1 );
-		if ( *destIx >= target )
-		{
-			++totalAudioBuffers;
-			soundBufferState[ currentSndBufferIx ] = SOUND_STATE_READY;
-			currentSndBufferIx = ( currentSndBufferIx + 1 ) % wtAudioEngine::SndBufferCnt;
+		// Wait on a partial buffer unless the voice is about to run dry
+		if ( ( ring.GetSampleCnt() < SamplesPerSubmit ) && ( queuedSubmits > 0 ) )
+			break;
+
+		// A short read is an underrun, hold the last sample instead of dropping to zero and clicking
+		int16_t* samples = reinterpret_cast<int16_t*>( soundDataBuffer[ currentSndBufferIx ] );
+		const uint32_t readCnt = ring.Read( samples, SamplesPerSubmit );
+		if ( readCnt > 0 ) {
+			lastSample = samples[ readCnt - 1 ];
+		}
 
-			destIx = &soundBufferBytesCnt[ currentSndBufferIx ];
-			( *destIx ) = 0;
+		for ( uint32_t sampleIx = readCnt; sampleIx < SamplesPerSubmit; ++sampleIx ) {
+			samples[ sampleIx ] = lastSample;
 		}
+
+		soundBufferBytesCnt[ currentSndBufferIx ] = BytesPerSubmit;
+		soundBufferState[ currentSndBufferIx ] = SOUND_STATE_READY;
+		currentSndBufferIx = ( currentSndBufferIx + 1 ) % wtAudioEngine::SndBufferCnt;
+
+		++totalAudioBuffers;
+		++queuedSubmits;
 	}
 }
 
 
+int32_t wtAudioEngine::ClampLatencyMs( const int32_t latencyMs )
+{
+	if ( latencyMs < MinLatencyMs ) {
+		return MinLatencyMs;
+	}
+	if ( latencyMs > MaxLatencyMs ) {
+		return MaxLatencyMs;
+	}
+	return latencyMs;
+}
+
+
 bool wtAudioEngine::AudioSubmit()
 {
 	if ( pSourceVoice == nullptr )
 		return false;
 
-	if ( consumeBufferIx == -1 )
-		return false;
-
-	if ( soundBufferState[ consumeBufferIx ] == SOUND_STATE_EMPTY )
+	if ( soundBufferState[ consumeBufferIx ] != SOUND_STATE_READY )
 		return false;
 
-	pSourceVoice->GetState( &audioState, 0 );
-
-	static bool stopped = false;
-	if ( audioState.BuffersQueued <= 2 ) {
-		pSourceVoice->Stop();
-		stopped = true;
-	}
-	else if ( stopped ) {
-		pSourceVoice->Start();
-		stopped = false;
-	}
-	else if ( audioState.BuffersQueued >= ( wtAudioEngine::SndBufferCnt - 1 ) ) {
-		pSourceVoice->FlushSourceBuffers();
-	}
-
 	const float freqScale = 1.00f;
 	const float resampleRate = freqScale * ( wtAudioEngine::SourceFreqHz / (float)wtAudioEngine::FreqHz );
 
-	static bool hold = false;
-
-	int soundDataSizeInBytes = soundBufferBytesCnt[ consumeBufferIx ];
-
-	dbgLastSoundSampleLength = static_cast<uint32_t>( 0.5f * soundDataSizeInBytes );
+	HRESULT hr = S_OK;
+	while ( soundBufferState[ consumeBufferIx ] == SOUND_STATE_READY )
+	{
+		int soundDataSizeInBytes = soundBufferBytesCnt[ consumeBufferIx ];
 
-	XAUDIO2_BUFFER audioBuffer;
-	memset( &audioBuffer, 0, sizeof( XAUDIO2_BUFFER ) );
-	audioBuffer.AudioBytes = soundDataSizeInBytes;
-	audioBuffer.pAudioData = (BYTE* const)&soundDataBuffer[ consumeBufferIx ];
-	audioBuffer.pContext = &soundBufferState[ consumeBufferIx ];
+		dbgLastSoundSampleLength = static_cast<uint32_t>( 0.5f * soundDataSizeInBytes );
 
-	consumeBufferIx = ( consumeBufferIx + 1 ) % wtAudioEngine::SndBufferCnt;
+		XAUDIO2_BUFFER audioBuffer;
+		memset( &audioBuffer, 0, sizeof( XAUDIO2_BUFFER ) );
+		audioBuffer.AudioBytes = soundDataSizeInBytes;
+		audioBuffer.pAudioData = (BYTE* const)&soundDataBuffer[ consumeBufferIx ];
+		audioBuffer.pContext = &soundBufferState[ consumeBufferIx ];
 
-	float originalFreq = 1.0f;
-	XAUDIO2_FILTER_PARAMETERS parms;
-	pSourceVoice->GetFrequencyRatio( &originalFreq );
-	pSourceVoice->GetFilterParameters( &parms );
+		soundBufferState[ consumeBufferIx ] = SOUND_STATE_SUBMITTED;
+		consumeBufferIx = ( consumeBufferIx + 1 ) % wtAudioEngine::SndBufferCnt;
 
-	XAUDIO2_VOICE_DETAILS voiceDetails;
-	pSourceVoice->GetVoiceDetails( &voiceDetails );
+		hr = pSourceVoice->SubmitSourceBuffer( &audioBuffer );
+		if ( FAILED( hr ) )
+		{
+			std::cout << "Source buffer creation failure";
+			return false;
+		}
 
-	HRESULT hr = pSourceVoice->SubmitSourceBuffer( &audioBuffer );
-	if ( FAILED( hr ) )
-	{
-		std::cout << "Source buffer creation failure";
-		return false;
+		++totalAudioSubmits;
 	}
 
-	++totalAudioSubmits;
-
 	UINT32 OperationID = UINT32( InterlockedIncrement( LPLONG( &OperationSetCounter ) ) );
 
 	pSourceVoice->SetFrequencyRatio( resampleRate, XAUDIO2_COMMIT_ALL );
@@ -209,20 +210,24 @@ void LogApu( wtFrameResult& frameResult )
 	ofstream sndLog;
 	sndLog.open( sndLogName.str(), ios::out | ios::binary );
 
-	const wtSampleQueue& pulse1 = frameResult.soundOutput->dbgPulse1;
-	const wtSampleQueue& pulse2 = frameResult.soundOutput->dbgPulse2;
-	const wtSampleQueue& triangle = frameResult.soundOutput->dbgTri;
-	const wtSampleQueue& noise = frameResult.soundOutput->dbgNoise;
-	const wtSampleQueue& dmc = frameResult.soundOutput->dbgDmc;
-	const wtSampleQueue& mixed = frameResult.soundOutput->dbgMixed;
+	const apuOutput_t& output = *frameResult.soundOutput;
+	const apuScopeChannel_t channels[] = { APU_SCOPE_PULSE1, APU_SCOPE_PULSE2, APU_SCOPE_TRI, APU_SCOPE_NOISE, APU_SCOPE_DMC, APU_SCOPE_MIXED };
 
-	sndLog << "ix,pulse1,pulse2,triangle,noise,dmc,mixed\n";
+	// One row per scope bucket, channels that weren't captured this frame are left empty
+	sndLog << "cycle,pulse1Min,pulse1Max,pulse2Min,pulse2Max,triangleMin,triangleMax,noiseMin,noiseMax,dmcMin,dmcMax,mixedMin,mixedMax\n";
 
-	const uint32_t sampleCnt = mixed.GetSampleCnt();
-	for ( uint32_t i = 0; i < sampleCnt; ++i )
+	for ( uint32_t i = 0; i < output.bucketCnt; ++i )
 	{
-		sndLog << i << "," << pulse1.Peek( i ) << "," << pulse2.Peek( i ) << "," << triangle.Peek( i );
-		sndLog << "," << noise.Peek( i ) << "," << dmc.Peek( i ) << "," << mixed.Peek( i ) << "\n";
+		sndLog << i * output.cyclesPerBucket;
+		for ( const apuScopeChannel_t channel : channels )
+		{
+			if ( output.channelBits & BIT_MASK( channel ) ) {
+				sndLog << "," << output.scope[ channel ].minLevel[ i ] << "," << output.scope[ channel ].maxLevel[ i ];
+			} else {
+				sndLog << ",,";
+			}
+		}
+		sndLog << "\n";
 	}
 
 	sndLog.close();
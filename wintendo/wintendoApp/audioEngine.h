@@ -20,12 +20,15 @@ enum SoundState
 struct wtAudioEngine
 {
 	static const uint32_t				SndBufferCnt		= 10;
-	static const uint32_t				SamplesPerSubmit	= 100000;
+	static const uint32_t				SamplesPerSubmit	= ApuOutputHz / 100; // 10ms
+	static const uint32_t				MinQueuedSubmits	= 3;
 	static const uint32_t				SampleSize			= sizeof( int16_t );
 	static const uint32_t				BytesPerSubmit		= SampleSize * SamplesPerSubmit;
 	static const uint32_t				BufferSize			= 1000 + BytesPerSubmit;
 	static const uint32_t				FreqHz				= 48000;
-	static const uint32_t				SourceFreqHz		= ApuSamplesPerSec;
+	static const uint32_t				SourceFreqHz		= ApuOutputHz;
+	static const int32_t				MinLatencyMs		= ( 1000 * SamplesPerSubmit ) / SourceFreqHz;	// One submit, less and Trim empties the ring every call
+	static const int32_t				MaxLatencyMs		= ( 1000 * ApuRingSize ) / SourceFreqHz;		// The whole APU ring
 
 	Microsoft::WRL::ComPtr<IXAudio2>	pXAudio2;
 	IXAudio2MasteringVoice*				pMasteringVoice;
@@ -43,7 +46,8 @@ struct wtAudioEngine
 	int32_t								totalAudioSubmits	= 0;
 	int32_t								totalAudioBuffers	= 0;
 	uint32_t							emulatorFrame		= 0;
-	uint32_t							frameResultIx		= 0;
+	int32_t								targetLatencyMs		= 50;
+	int16_t								lastSample			= 0;
 
 #if defined(_DEBUG)
 	bool								enableSound			= false;
@@ -62,7 +66,8 @@ struct wtAudioEngine
 
 	void								Init();
 	void								Shutdown();
-	void								EncodeSamples( wtSampleQueue& soundQueue );
+	void								EncodeSamples( wtAudioRing& ring );
+	static int32_t						ClampLatencyMs( const int32_t latencyMs );
 	bool								AudioSubmit();
 };
 
@@ -5,16 +5,51 @@ static const uint32_t FramePlotSampleCount = 500;
 using frameSampleBuffer = wtQueue< float, FramePlotSampleCount >;
 static frameSampleBuffer frameTimePlot;
 
+static const char* SyncEventNames[ SYNC_EVENT_COUNT ] =
+{
+	"NMI",
+	"Mapper IRQ",
+	"Frame IRQ",
+	"DMC",
+	"Frame State",
+	"Epoch",
+	"PPU Register",
+	"APU Register",
+	"Mapper Register",
+	"Trace",
+};
+
 static float ImGuiGetFrameSample( void* data, int32_t idx )
 {
 	frameSampleBuffer* queue = reinterpret_cast<frameSampleBuffer*>( data );
 	return queue->Peek( idx );
 }
 
-static float ImGuiGetSoundSample( void* data, int32_t idx )
+static float ImGuiGetScopeSample( void* data, int32_t idx )
 {
-	wtSampleQueue* queue = reinterpret_cast<wtSampleQueue*>( data );
-	return queue->Peek( idx );
+	// Alternates each bucket's min and max so the line traces the envelope
+	const apuScopeTrace_t* trace = reinterpret_cast<const apuScopeTrace_t*>( data );
+	const uint32_t bucketIx = trace->triggerIx + ( idx >> 1 );
+	return ( idx & 1 ) ? trace->maxLevel[ bucketIx ] : trace->minLevel[ bucketIx ];
+}
+
+static void PlotScope( const char* label, apuOutput_t* output, const apuScopeChannel_t channel, const float scale )
+{
+	apuScopeTrace_t* trace = &output->scope[ channel ];
+
+	uint32_t bucketCnt = 0;
+	if ( ( output->channelBits & BIT_MASK( channel ) ) && ( output->bucketCnt > trace->triggerIx ) ) {
+		bucketCnt = std::min<uint32_t>( ApuScopeWindowCnt, output->bucketCnt - trace->triggerIx );
+	}
+
+	ImGui::PlotLines( label, &ImGuiGetScopeSample,
+		reinterpret_cast<void*>( trace ),
+		2 * bucketCnt,
+		0,
+		NULL,
+		-scale,
+		scale,
+		ImVec2( 1000.0f, 100.0f ) );
 }
 
 void wtRenderer::BuildImguiCommandList()
@@ -148,6 +183,30 @@ void wtRenderer::BuildImguiCommandList()
 				ImGui::Columns( 1 );
 			}
 
+			if ( ImGui::CollapsingHeader( "Profiler", ImGuiTreeNodeFlags_OpenOnArrow ) )
+			{
+				if ( ImGui::Button( "Start##Profiler" ) ) {
+					sysCmd_t profileCmd;
+					profileCmd.type = sysCmdType_t::START_PROFILE;
+					nesSystem.SubmitCommand( profileCmd );
+				}
+				ImGui::SameLine();
+				if ( ImGui::Button( "Stop##Profiler" ) ) {
+					sysCmd_t profileCmd;
+					profileCmd.type = sysCmdType_t::STOP_PROFILE;
+					nesSystem.SubmitCommand( profileCmd );
+				}
+				if ( fr->profile.totalStats.count > 0 )
+				{
+					const profileStat_t& total = fr->profile.totalStats;
+					ImGui::Text( "Instructions: %llu",	total.count );
+					ImGui::Text( "Cycles: %llu",		total.cycles );
+					if ( ImGui::Button( "Copy Report" ) ) {
+						ToClipboard( nesSystem.GetProfileReport( fr->profile, profileSnapshot_t::MaxHotSpots ) );
+					}
+				}
+			}
+
 			if ( ImGui::CollapsingHeader( "Timing", ImGuiTreeNodeFlags_OpenOnArrow ) )
 			{
 				ImGui::Text( "Frame Cycle Start: %u",					fr->dbgInfo.cycleBegin );
@@ -155,6 +214,11 @@ void wtRenderer::BuildImguiCommandList()
 				ImGui::Text( "Frame Cycles: %u",						( fr->dbgInfo.cycleEnd - fr->dbgInfo.cycleBegin ) );
 				ImGui::Text( "State Cycle: %u",							fr->dbgInfo.stateCycle );
 				ImGui::Separator();
+				for ( uint32_t i = 0; i < SYNC_EVENT_COUNT; ++i ) {
+					ImGui::Text( "Sync - %s: %u", SyncEventNames[ i ], fr->dbgInfo.syncCount[ i ] );
+				}
+				ImGui::Text( "Idle Cycles Skipped: %u",					fr->dbgInfo.skippedCycles );
+				ImGui::Separator();
 				ImGui::Text( "Avg %.3f ms/frame (%.1f FPS)",			avgFrameTime / 1000.0f, 1000000.0f / avgFrameTime );
 				ImGui::Text( "Display Frame #%i",						frameNumber );
 				ImGui::Text( "Emulator Frame #%i",						fr->dbgInfo.frameNumber );
@@ -295,7 +359,7 @@ void wtRenderer::BuildImguiCommandList()
 			if ( ImGui::CollapsingHeader( "Frame Buffer", ImGuiTreeNodeFlags_OpenOnArrow ) )
 			{
 				const uint32_t imageId = 0;
-				const wtRawImageInterface* srcImage = fr->frameBuffer;
+				const wtRawImageInterface* srcImage = ( fr->frameBuffer != nullptr ) ? fr->frameBuffer : &expandedFrameBuffer;
 				ImGui::Image( (ImTextureID)textureResources[ currentFrameIx ][ imageId ].gpuHandle.ptr, ImVec2( (float)srcImage->GetWidth(), (float)srcImage->GetHeight() ) );
 			}
 
@@ -352,6 +416,7 @@ void wtRenderer::BuildImguiCommandList()
 			{
 				ImGui::Checkbox( "Show BG",			&systemConfig.ppu.showBG );
 				ImGui::Checkbox( "Show Sprite",		&systemConfig.ppu.showSprite );
+				ImGui::Checkbox( "Sprite Picking",	&systemConfig.ppu.spriteIdBuffer );
 				ImGui::SliderInt( "Line Sprites",	&systemConfig.ppu.spriteLimit, 1, PPU::TotalSprites );
 			}
 
@@ -376,6 +441,24 @@ void wtRenderer::BuildImguiCommandList()
 				ImGui::Columns( 1 );
 			}
 
+			if ( ImGui::CollapsingHeader( "VRAM Heatmap", ImGuiTreeNodeFlags_OpenOnArrow ) )
+			{
+				if ( ImGui::Button( "Start##VramHeatmap" ) ) {
+					sysCmd_t heatmapCmd;
+					heatmapCmd.type = sysCmdType_t::START_VRAM_HEATMAP;
+					nesSystem.SubmitCommand( heatmapCmd );
+				}
+				ImGui::SameLine();
+				if ( ImGui::Button( "Stop##VramHeatmap" ) ) {
+					sysCmd_t heatmapCmd;
+					heatmapCmd.type = sysCmdType_t::STOP_VRAM_HEATMAP;
+					nesSystem.SubmitCommand( heatmapCmd );
+				}
+				// Writes in the last frame, one pixel per address from $0000 and 8 rows per 1KB
+				const wtAppTextureD3D12& heatmap = textureResources[ currentFrameIx ][ SHADER_RESOURES_VRAM_HEATMAP ];
+				ImGui::Image( (ImTextureID)heatmap.gpuHandle.ptr, ImVec2( 2.0f * heatmap.width, 2.0f * heatmap.height ) );
+			}
+
 			if ( ImGui::CollapsingHeader( "NT Memory", ImGuiTreeNodeFlags_OpenOnArrow ) )
 			{
 				static MemoryEditor ppuMemEdit;
@@ -418,14 +501,7 @@ void wtRenderer::BuildImguiCommandList()
 				ImGui::Text( "$4001 - Sweep Negate: %i",	apuDebug.pulse1.regRamp.sem.negate );
 				ImGui::Columns( 1 );
 
-				ImGui::PlotLines( "Pulse1 Wave", &ImGuiGetSoundSample,
-					reinterpret_cast<void*>( &fr->soundOutput->dbgPulse1 ),
-					ApuBufferSize,
-					0,
-					NULL,
-					-waveGraphScale,
-					waveGraphScale,
-					ImVec2( 1000.0f, 100.0f ) );
+				PlotScope( "Pulse1 Wave", fr->soundOutput, APU_SCOPE_PULSE1, waveGraphScale );
 			}
 			if ( ImGui::CollapsingHeader( "Pulse 2", ImGuiTreeNodeFlags_OpenOnArrow ) )
 			{
@@ -435,7 +511,7 @@ void wtRenderer::BuildImguiCommandList()
 				ImGui::SameLine();
 				ImGui::Text( "| $4015 - Enabled: %i",		apuDebug.status.sem.p2 );
 				ImGui::Columns( 2 );
-				ImGui::Text( "Samples: %i",					fr->soundOutput->dbgPulse2.GetSampleCnt() );
+				ImGui::Text( "Trigger Bucket: %i",		fr->soundOutput->scope[ APU_SCOPE_PULSE2 ].triggerIx );
 				ImGui::Text( "$4004 - Duty: %i",			apuDebug.pulse2.regCtrl.sem.duty );
 				ImGui::Text( "$4004 - Constant: %i",		apuDebug.pulse2.regCtrl.sem.isConstant );
 				ImGui::Text( "$4004 - Reg Volume: %i",		apuDebug.pulse2.regCtrl.sem.volume );
@@ -451,14 +527,7 @@ void wtRenderer::BuildImguiCommandList()
 				ImGui::Text( "$4005 - Sweep Negate: %i",	apuDebug.pulse2.regRamp.sem.negate );
 				ImGui::Columns( 1 );
 
-				ImGui::PlotLines( "Pulse2 Wave", &ImGuiGetSoundSample,
-					reinterpret_cast<void*>( &fr->soundOutput->dbgPulse2 ),
-					ApuBufferSize,
-					0,
-					NULL,
-					-waveGraphScale,
-					waveGraphScale,
-					ImVec2( 1000.0f, 100.0f ) );
+				PlotScope( "Pulse2 Wave", fr->soundOutput, APU_SCOPE_PULSE2, waveGraphScale );
 			}
 			if ( ImGui::CollapsingHeader( "Triangle", ImGuiTreeNodeFlags_OpenOnArrow ) )
 			{
@@ -468,7 +537,7 @@ void wtRenderer::BuildImguiCommandList()
 				ImGui::SameLine();
 				ImGui::Text( "| $4015 - Enabled: %i",		apuDebug.status.sem.t );
 				ImGui::Columns( 2 );
-				ImGui::Text( "Samples: %i",					fr->soundOutput->dbgTri.GetSampleCnt() );
+				ImGui::Text( "Trigger Bucket: %i",		fr->soundOutput->scope[ APU_SCOPE_TRI ].triggerIx );
 				ImGui::Text( "Length Counter: %i",			apuDebug.triangle.lengthCounter );
 				ImGui::Text( "Linear Counter: %i",			apuDebug.triangle.linearCounter.Value() );
 				ImGui::Text( "Timer: %i",					apuDebug.triangle.timer.Value() );
@@ -479,14 +548,7 @@ void wtRenderer::BuildImguiCommandList()
 				ImGui::Text( "$400B - Counter: %i",			apuDebug.triangle.regTimer.sem0.counter );
 				ImGui::Columns( 1 );
 
-				ImGui::PlotLines( "Triangle Wave", &ImGuiGetSoundSample,
-					reinterpret_cast<void*>( &fr->soundOutput->dbgTri ),
-					ApuBufferSize,
-					0,
-					NULL,
-					-waveGraphScale,
-					waveGraphScale,
-					ImVec2( 1000.0f, 100.0f ) );
+				PlotScope( "Triangle Wave", fr->soundOutput, APU_SCOPE_TRI, waveGraphScale );
 			}
 			if ( ImGui::CollapsingHeader( "Noise", ImGuiTreeNodeFlags_OpenOnArrow ) )
 			{
@@ -496,7 +558,7 @@ void wtRenderer::BuildImguiCommandList()
 				ImGui::SameLine();
 				ImGui::Text( "| $4015 - Enabled: %i",		apuDebug.status.sem.n );
 				ImGui::Columns( 2 );
-				ImGui::Text( "Samples: %i",					fr->soundOutput->dbgNoise.GetSampleCnt() );
+				ImGui::Text( "Trigger Bucket: %i",		fr->soundOutput->scope[ APU_SCOPE_NOISE ].triggerIx );
 				ImGui::Text( "Shifter: %i",					apuDebug.noise.shift.Value() );
 				ImGui::Text( "Timer: %i",					apuDebug.noise.timer );
 				ImGui::NextColumn();
@@ -508,14 +570,7 @@ void wtRenderer::BuildImguiCommandList()
 				ImGui::Text( "$400F - Length Counter: %i",	apuDebug.noise.regFreq2.sem.length );
 				ImGui::Columns( 1 );
 
-				ImGui::PlotLines( "Noise Wave", &ImGuiGetSoundSample,
-					reinterpret_cast<void*>( &fr->soundOutput->dbgNoise ),
-					ApuBufferSize,
-					0,
-					NULL,
-					-waveGraphScale,
-					waveGraphScale,
-					ImVec2( 1000.0f, 100.0f ) );
+				PlotScope( "Noise Wave", fr->soundOutput, APU_SCOPE_NOISE, waveGraphScale );
 			}
 			if ( ImGui::CollapsingHeader( "DMC", ImGuiTreeNodeFlags_OpenOnArrow ) )
 			{
@@ -525,7 +580,7 @@ void wtRenderer::BuildImguiCommandList()
 				ImGui::SameLine();
 				ImGui::Text( "| $4015 - Enabled: %i",		apuDebug.status.sem.d );
 				ImGui::Columns( 2 );
-				ImGui::Text( "Samples: %i",					fr->soundOutput->dbgDmc.GetSampleCnt() );
+				ImGui::Text( "Trigger Bucket: %i",		fr->soundOutput->scope[ APU_SCOPE_DMC ].triggerIx );
 				ImGui::Text( "Volume: %i",					apuDebug.dmc.outputLevel.Value() );
 				ImGui::Text( "Sample Buffer: %i",			apuDebug.dmc.sampleBuffer );
 				ImGui::Text( "Bit Counter: %i",				apuDebug.dmc.bitCnt );
@@ -542,14 +597,7 @@ void wtRenderer::BuildImguiCommandList()
 				ImGui::Text( "$4013 - Length: %i",			apuDebug.dmc.regLength );
 				ImGui::Columns( 1 );
 
-				ImGui::PlotLines( "DMC Wave", &ImGuiGetSoundSample,
-					reinterpret_cast<void*>( &fr->soundOutput->dbgDmc ),
-					ApuBufferSize,
-					0,
-					NULL,
-					-waveGraphScale,
-					waveGraphScale,
-					ImVec2( 1000.0f, 100.0f ) );
+				PlotScope( "DMC Wave", fr->soundOutput, APU_SCOPE_DMC, waveGraphScale );
 			}
 			if ( ImGui::CollapsingHeader( "Frame Counter", ImGuiTreeNodeFlags_OpenOnArrow ) )
 			{
@@ -567,6 +615,9 @@ void wtRenderer::BuildImguiCommandList()
 				ImGui::InputInt( "Pulse Wave Shift",		&systemConfig.apu.waveShift );
 				ImGui::Checkbox( "Disable Sweep",			&systemConfig.apu.disableSweep );
 				ImGui::Checkbox( "Disable Envelope",		&systemConfig.apu.disableEnvelope );
+				if ( ImGui::InputInt( "Scope Cycles Per Bucket",	&systemConfig.apu.scopeCyclesPerBucket ) ) {
+					systemConfig.apu.scopeCyclesPerBucket = std::max<int32_t>( ApuScopeMinBucketCycles, systemConfig.apu.scopeCyclesPerBucket );
+				}
 			}
 			if ( ImGui::CollapsingHeader( "Filters", ImGuiTreeNodeFlags_OpenOnArrow ) )
 			{
@@ -578,16 +629,15 @@ void wtRenderer::BuildImguiCommandList()
 				ImGui::InputFloat( "LowPass Freq:",		&app->audio->F3 );
 			}
 
-			ImGui::PlotLines( "Audio Wave", &ImGuiGetSoundSample,
-				reinterpret_cast<void*>( &fr->soundOutput->dbgMixed ),
-				ApuBufferSize,
-				0,
-				NULL,
-				-waveGraphScale,
-				waveGraphScale,
-				ImVec2( 1000.0f, 100.0f ) );
+			PlotScope( "Audio Wave", fr->soundOutput, APU_SCOPE_MIXED, waveGraphScale );
 
-			ImGui::Text( "Emulated Samples: %i",		fr->soundOutput->mixed.GetSampleCnt() );
+			wtAudioRing& audioRing = nesSystem.GetAudioRing();
+			if ( ImGui::InputInt( "Target Latency MS",	&app->audio->targetLatencyMs ) ) {
+				app->audio->targetLatencyMs = wtAudioEngine::ClampLatencyMs( app->audio->targetLatencyMs );
+			}
+			ImGui::Text( "Buffered Samples: %i",		audioRing.GetSampleCnt() );
+			ImGui::Text( "Underruns: %i",				audioRing.GetUnderrunCnt() );
+			ImGui::Text( "Overruns: %i",				audioRing.GetOverrunCnt() );
 			ImGui::Text( "Submitted Samples: %i",		app->audio->dbgLastSoundSampleLength );
 			ImGui::Text( "Target MS: %4.2f",			1000.0f * app->audio->dbgLastSoundSampleLength / (float)wtAudioEngine::SourceFreqHz );
 			ImGui::Text( "Average MS: %4.2f",			voiceCallback.totalDuration / voiceCallback.processedQueues );
@@ -139,6 +139,7 @@ enum ShaderResources
 	SHADER_RESOURES_PATTERN0,
 	SHADER_RESOURES_PATTERN1,
 	SHADER_RESOURES_OBJECT,
+	SHADER_RESOURES_VRAM_HEATMAP,
 	SHADER_RESOURES_CHRBANK0,
 	SHADER_RESOURES_CHRBANK_CNT = 32,
 
@@ -160,6 +161,7 @@ private:
 	command_t								cmd;
 
 	std::vector<wtAppTextureD3D12>			textureResources[ FrameCount ];
+	wtDisplayImage							expandedFrameBuffer; // Upload source when the system outputs palette indices
 
 public:
 
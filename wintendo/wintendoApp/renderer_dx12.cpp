@@ -414,6 +414,7 @@ void wtRenderer::CreateTextureResources( const uint32_t frameIx )
 	sourceImages[ dbgImageIx++ ] = { 128, 128 };
 	sourceImages[ dbgImageIx++ ] = { 128, 128 };
 	sourceImages[ dbgImageIx++ ] = { 8, 16 };
+	sourceImages[ dbgImageIx++ ] = { 128, 128 };
 
 	for ( int i = 0; i < SHADER_RESOURES_CHRBANK_CNT; ++i )
 	{
@@ -586,12 +587,20 @@ void wtRenderer::IssueTextureCopyCommands( const uint32_t srcFrameIx, const uint
 	uint32_t imageIx = 0;
 	const wtRawImageInterface* sourceImages[ SHADER_RESOURES_TEXTURE_CNT ];
 	// All that this needs right now are the dimensions.
-	sourceImages[ imageIx++ ] = fr->frameBuffer;
+	if ( fr->indexedFrameBuffer != nullptr )
+	{
+		// Indexed output leaves frameBuffer null, resolve it through the palette for the upload
+		app->system->ExpandFrameBuffer( *fr->indexedFrameBuffer, expandedFrameBuffer );
+		sourceImages[ imageIx++ ] = &expandedFrameBuffer;
+	} else {
+		sourceImages[ imageIx++ ] = fr->frameBuffer;
+	}
 	sourceImages[ imageIx++ ] = fr->nameTableSheet;
 	sourceImages[ imageIx++ ] = fr->paletteDebug;
 	sourceImages[ imageIx++ ] = fr->patternTable0;
 	sourceImages[ imageIx++ ] = fr->patternTable1;
 	sourceImages[ imageIx++ ] = fr->pickedObj8x16;
+	sourceImages[ imageIx++ ] = fr->vramHeatmap;
 
 	for ( int i = 0; i < SHADER_RESOURES_CHRBANK_CNT; ++i )
 	{
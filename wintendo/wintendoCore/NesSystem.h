@@ -32,6 +32,7 @@ struct wtFrameResult
 	uint64_t					stateCount;
 	playbackState_t				playbackState;
 	wtDisplayImage*				frameBuffer;
+	wtIndexedDisplayImage*		indexedFrameBuffer; // Replaces frameBuffer when config.ppu.indexedFrameBuffer is set
 	apuOutput_t*				soundOutput;
 	wtStateBlob*				frameState;
 
@@ -47,10 +48,12 @@ struct wtFrameResult
 	wtPatternTableImage*		patternTable0;
 	wtPatternTableImage*		patternTable1;
 	wt16x8ChrImage*				pickedObj8x16;
+	wtVramHeatmapImage*			vramHeatmap; // Cleared while no heatmap is attached
 	cpuDebug_t					cpuDebug;
 	apuDebug_t					apuDebug;
 	ppuDebug_t					ppuDebug;
 	wtLog*						dbgLog;
+	profileSnapshot_t			profile; // totalStats.count is 0 until the profiler has samples
 };
 
 
@@ -63,6 +66,7 @@ public:
 	static const uint32_t VirtualMemorySize		= 0x10000;
 	static const uint32_t PhysicalMemorySize	= 0x0800;
 	static const uint32_t PageSize				= 0x0100;
+	static const uint32_t PageCount				= ( VirtualMemorySize / PageSize );
 	static const uint32_t ZeroPageEnd			= 0x00FF;
 	static const uint32_t BankSize				= 0x4000;
 	static const uint32_t SramSize				= 0x2000;
@@ -99,6 +103,9 @@ public:
 	unique_ptr<wtCart>			cart;
 
 private:
+	typedef uint8_t( wtSystem::* ReadHandlerFn )( const uint16_t address );
+	typedef void( wtSystem::* WriteHandlerFn )( const uint16_t address, const uint16_t offset, const uint8_t value );
+
 	static const uint32_t		MaxStates = 5000;
 
 	wstring						fileName;
@@ -107,7 +114,14 @@ private:
 	PPU							ppu;
 	APU							apu;
 	uint8_t						memory[ PhysicalMemorySize ];
+	uint8_t*					readPages[ PageCount ];		// Direct pointer per page, nullptr falls back to readHandlers
+	uint8_t*					writePages[ PageCount ];	// Direct pointer per page, nullptr falls back to writeHandlers
+	ReadHandlerFn				readHandlers[ PageCount ];
+	WriteHandlerFn				writeHandlers[ PageCount ];
 	masterCycle_t				sysCycles;
+	masterCycle_t				runEndCycle;
+	cpuCycle_t					syncCycle;
+	syncEvent_t					syncEvent;
 	bool						replayFinished;
 	bool						debugNTEnable;
 	int64_t						overflowCycles;
@@ -117,11 +131,16 @@ private:
 #endif // #if DEBUG_ADDR == 1
 	wtFrameResult				result;
 	wtDisplayImage				frameBuffer[ OutputBuffersCount ];
+	wtIndexedDisplayImage		indexedFrameBuffer[ OutputBuffersCount ];
+	wtSpriteIdImage				spriteIdBuffer;
 	wtNameTableImage			nameTableSheet;
 	wtPaletteImage				paletteDebug;
 	wtPatternTableImage			patternTable0;
 	wtPatternTableImage			patternTable1;
 	wt16x8ChrImage				pickedObj8x16;
+	unique_ptr<wtVramHeatmap>	vramHeatmap; // Allocated by START_VRAM_HEATMAP, the PPU writes through it
+	wtVramHeatmapImage			vramHeatmapImage;
+	profileSnapshot_t			profileSnapshot; // Rebuilt on the emulator thread when the profiler has new samples
 	std::deque<wtStateBlob>		states;
 	wtStateBlob					frameState;
 	uint32_t					currentState;
@@ -149,8 +168,12 @@ public:
 	void Reset()
 	{
 		sysCycles = masterCycle_t( 0 );
+		runEndCycle = masterCycle_t( 0 );
+		syncCycle = cpuCycle_t( 0 );
+		syncEvent = SYNC_EVENT_EPOCH;
 
 		memset( memory, 0, PhysicalMemorySize );
+		ResetMemoryMap();
 
 		strobeOn = false;
 		btnShift[0] = 0;
@@ -158,10 +181,13 @@ public:
 
 		previousFrameNumber = 0;
 
-		mirrorMode = MIRROR_MODE_HORIZONTAL;
+		SetMirrorMode( MIRROR_MODE_HORIZONTAL );
 
 		debugNTEnable = true;
 
+		profileSnapshot.totalStats = { 0, 0 };
+		profileSnapshot.hotSpotCount = 0;
+
 		replayFinished = true;
 		toggledFrame = false;
 
@@ -170,18 +196,25 @@ public:
 		patternTable0.SetDebugName( "PatternTable0" );
 		patternTable1.SetDebugName( "PatternTable1" );
 		pickedObj8x16.SetDebugName( "Picked Object 8x16" );
+		vramHeatmapImage.SetDebugName( "VRAM Heatmap" );
 
 		for( uint32_t i = 0; i < OutputBuffersCount; ++i ) {
 			frameBuffer[i].Clear();
 			char dbgName[ 128 ];
 			sprintf_s( dbgName, "FrameBuffer%i", i );
 			frameBuffer[ i ].SetDebugName( dbgName );
+			indexedFrameBuffer[ i ].Clear();
 		}
+		spriteIdBuffer.Clear( PPU::NoSpriteId );
 		nameTableSheet.Clear();
 		paletteDebug.Clear();
 		patternTable0.Clear();
 		patternTable1.Clear();
 		pickedObj8x16.Clear();
+		vramHeatmapImage.Clear();
+		if ( vramHeatmap != nullptr ) {
+			vramHeatmap->Reset();
+		}
 
 		states.clear();
 		playbackState.currentFrame = 0;
@@ -201,10 +234,14 @@ public:
 	uint8_t&				GetStack();
 	uint8_t					ReadMemory( const uint16_t address );
 	void					WriteMemory( const uint16_t address, const uint16_t offset, const uint8_t value );
+	void					MapCpuMemory( const uint16_t address, const uint32_t size, uint8_t* readPtr, uint8_t* writePtr );
+	bool					IsRomMemory( const uint16_t address ) const;
+	int32_t					GetPrgRomOffset( const uint16_t address ) const;
 	uint8_t					ReadZeroPage( const uint16_t address );
 	uint8_t					GetMapperId() const;
 	uint8_t					GetMirrorMode() const;
 	void					SetMirrorMode( uint8_t mode );
+	void					MapPpuMemory( const uint16_t address, const uint32_t size, uint8_t* readPtr, uint8_t* writePtr );
 	void					RequestNMI( const uint16_t vector ) const;
 	void					RequestNMI() const;
 	void					RequestIRQ() const;
@@ -213,6 +250,8 @@ public:
 	void					SaveFrameState();
 	void					ToggleFrame();
 	wtDisplayImage*			GetBackbuffer();
+	wtIndexedDisplayImage*	GetIndexedBackbuffer();
+	wtSpriteIdImage*		GetSpriteIdBuffer();
 	void					Serialize( Serializer& serializer );
 	unique_ptr<wtMapper>	AssignMapper( const uint32_t mapperId ); // In "mapper.h"
 
@@ -221,6 +260,7 @@ public:
 	void					Shutdown();
 	void					LoadProgram( const uint32_t resetVectorManual = 0x10000 );
 	string					GetPrgBankDissambly( const uint8_t bankNum );
+	string					GetProfileReport( const profileSnapshot_t& profile, const uint32_t maxHotSpots );
 	void					GenerateRomDissambly( string prgRomAsm[128] );
 	void					GenerateChrRomTables( wtPatternTableImage chrRom[32] );
 	void					GetChrRomPalette( const uint8_t paletteId, RGBA palette[ 4 ] );
@@ -230,13 +270,14 @@ public:
 	uint8_t					ReadInput( const uint16_t address );
 	void					WriteInput( const uint16_t address, const uint8_t value );
 	void					GetFrameResult( wtFrameResult& outFrameResult );
+	void					ExpandFrameBuffer( const wtIndexedDisplayImage& src, wtDisplayImage& dest, const BitmapFormat format = BITMAP_RGBA ) const;
 	void					GetState( cpuDebug_t& state );
 	const PPU&				GetPPU() const;
 	const APU&				GetAPU() const;
+	wtAudioRing&			GetAudioRing();
 	void					SetConfig( config_t& cfg );
 	void					SaveSate();
 	void					LoadState();
-	bool					MouseInRegion( const wtRect& region );
 	static void				InitConfig( config_t& cfg );
 	wtInput*				GetInput();
 	const config_t*			GetConfig();
@@ -246,7 +287,16 @@ public:
 
 private:
 	void					DebugPrintFlushLog();
+	void					PickSprite();
+	void					UpdateProfileSnapshot();
 	void					WritePhysicalMemory( const uint16_t address, const uint8_t value );
+	void					ResetMemoryMap();
+	uint8_t					ReadPpuRegister( const uint16_t address );
+	uint8_t					ReadIoRegister( const uint16_t address );
+	uint8_t					ReadCartMemory( const uint16_t address );
+	void					WritePpuRegister( const uint16_t address, const uint16_t offset, const uint8_t value );
+	void					WriteIoRegister( const uint16_t address, const uint16_t offset, const uint8_t value );
+	void					WriteCartMemory( const uint16_t address, const uint16_t offset, const uint8_t value );
 	uint16_t				MirrorAddress( const uint16_t address ) const;
 	void					RecordSate( wtStateBlob& state );
 	void					RestoreState( const wtStateBlob& state );
@@ -254,6 +304,9 @@ private:
 	void					SaveSRam();
 	void					LoadSRam();
 	void					BackgroundUpdate();
+	masterCycle_t			AlignToTick( const masterCycle_t& cycle ) const;
+	void					ScheduleSync();
+	void					CatchUp( const cpuCycle_t& targetCycle, const syncEvent_t event );
 
 	// command.cpp
 	void					ProcessCommands();
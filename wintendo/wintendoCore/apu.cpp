@@ -2,9 +2,99 @@
 #include "apu.h"
 #include "NesSystem.h"
 #include <algorithm>
+#include <cmath>
 
 //#pragma optimize("", off)
 
+void wtBlipBuffer::Init( const double clockHz, const double sampleHz )
+{
+	factor = static_cast<uint64_t>( ( sampleHz / clockHz ) * ( 1ull << FracBits ) + 0.5 );
+	maxFrameClocks = static_cast<uint32_t>( ( ApuOutputBufferSize - 1 ) * ( clockHz / sampleHz ) );
+
+	// Windowed sinc impulses, one per sub-sample phase. The buffer stores the derivative of the
+	// output so each impulse integrates to a band-limited step of the delta's height.
+	const double Pi = 3.14159265358979323846;
+	const double cutoff = 0.45; // Fraction of the sample rate, just under Nyquist
+	const double halfWidth = 0.5 * KernelTaps;
+
+	for ( uint32_t phase = 0; phase < KernelPhases; ++phase )
+	{
+		double impulse[ KernelTaps ];
+		double sum = 0.0;
+
+		for ( uint32_t tap = 0; tap < KernelTaps; ++tap )
+		{
+			const double x = tap - halfWidth + 1.0 - ( phase / static_cast<double>( KernelPhases ) );
+			const double sinc = ( x == 0.0 ) ? 1.0 : ( sin( 2.0 * Pi * cutoff * x ) / ( 2.0 * Pi * cutoff * x ) );
+			const double window = 0.42 + 0.5 * cos( Pi * x / halfWidth ) + 0.08 * cos( 2.0 * Pi * x / halfWidth );
+
+			impulse[ tap ] = ( fabs( x ) < halfWidth ) ? ( sinc * window ) : 0.0;
+			sum += impulse[ tap ];
+		}
+
+		// Round so every phase sums to exactly 1.0, otherwise the integrator drifts
+		int32_t total = 0;
+		for ( uint32_t tap = 0; tap < KernelTaps; ++tap )
+		{
+			kernel[ phase ][ tap ] = static_cast<int32_t>( floor( ( impulse[ tap ] / sum ) * ( 1 << KernelBits ) + 0.5 ) );
+			total += kernel[ phase ][ tap ];
+		}
+		kernel[ phase ][ KernelTaps / 2 ] += ( 1 << KernelBits ) - total;
+	}
+
+	Clear();
+}
+
+
+void wtBlipBuffer::Clear()
+{
+	offset = 0;
+	integrator = 0;
+	memset( buffer, 0, sizeof( buffer ) );
+}
+
+
+void wtBlipBuffer::AddDelta( const uint32_t clockTime, const int32_t delta )
+{
+	const uint64_t pos = offset + clockTime * factor;
+	const uint32_t sampleIx = static_cast<uint32_t>( pos >> FracBits );
+	const uint32_t phase = static_cast<uint32_t>( pos >> ( FracBits - PhaseBits ) ) & ( KernelPhases - 1 );
+
+	assert( ( sampleIx + KernelTaps ) <= BufferSize );
+	if ( ( sampleIx + KernelTaps ) > BufferSize ) {
+		return;
+	}
+
+	int64_t* out = &buffer[ sampleIx ];
+	const int32_t* impulse = kernel[ phase ];
+	for ( uint32_t tap = 0; tap < KernelTaps; ++tap ) {
+		out[ tap ] += static_cast<int64_t>( delta ) * impulse[ tap ];
+	}
+}
+
+
+uint32_t wtBlipBuffer::EndFrame( const uint32_t clockDuration, int16_t* output )
+{
+	assert( clockDuration <= maxFrameClocks );
+
+	offset += clockDuration * factor;
+	const uint32_t sampleCnt = static_cast<uint32_t>( offset >> FracBits );
+	offset &= ( 1ull << FracBits ) - 1;
+
+	for ( uint32_t i = 0; i < sampleCnt; ++i )
+	{
+		integrator += buffer[ i ];
+		const int64_t sample = ( integrator >> KernelBits );
+		output[ i ] = static_cast<int16_t>( std::max<int64_t>( INT16_MIN, std::min<int64_t>( INT16_MAX, sample ) ) );
+	}
+
+	memmove( buffer, &buffer[ sampleCnt ], ( BufferSize - sampleCnt ) * sizeof( buffer[ 0 ] ) );
+	memset( &buffer[ BufferSize - sampleCnt ], 0, sampleCnt * sizeof( buffer[ 0 ] ) );
+
+	return sampleCnt;
+}
+
+
 float APU::GetPulseFrequency( PulseChannel& pulse )
 {
 	float freq = CPU_HZ / ( 16.0f * pulse.period.Value() + 1 );
@@ -320,7 +410,7 @@ void APU::ExecPulseChannel( PulseChannel& pulse )
 		pulseSample = 0;
 	}
 
-	pulse.sample = pulseSample;
+	SetChannelSample( pulse.sample, pulseSample );
 }
 
 
@@ -348,7 +438,18 @@ void APU::ExecChannelTri()
 		volume = 0;
 	}
 
-	triangle.sample = volume;
+	SetChannelSample( triangle.sample, volume );
+}
+
+
+void APU::ClockNoiseShift()
+{
+	const uint16_t shiftValue = noise.shift.Value();
+	const uint16_t bitShift = noise.regFreq1.sem.mode ? 6 : 1;
+	const uint16_t feedback = ( shiftValue ^ ( shiftValue >> bitShift ) ) & BIT_MASK( 0 );
+	const uint16_t newShift = ( ( shiftValue >> 1 ) & ~BIT_MASK( 14 ) ) | ( feedback << 14 );
+
+	noise.shift.Reload( newShift );
 }
 
 
@@ -357,12 +458,7 @@ void APU::ExecChannelNoise()
 	noise.timer.Dec();
 	if ( noise.timer.IsZero() )
 	{
-		const uint16_t shiftValue = noise.shift.Value();
-		const uint16_t bitShift = noise.regFreq1.sem.mode ? 6 : 1;
-		const uint16_t feedback = ( shiftValue ^ ( shiftValue >> bitShift ) ) & BIT_MASK( 0 );
-		const uint16_t newShift = ( ( shiftValue >> 1 ) & ~BIT_MASK( 14 ) ) | ( feedback << 14 );
-
-		noise.shift.Reload( newShift );
+		ClockNoiseShift();
 		noise.timer.Reload( NoiseLUT[NTSC][ noise.regFreq1.sem.period ] );
 	}
 
@@ -371,7 +467,7 @@ void APU::ExecChannelNoise()
 		volume = 0;
 	}
 
-	noise.sample = volume;
+	SetChannelSample( noise.sample, volume );
 }
 
 
@@ -475,7 +571,7 @@ void APU::ExecChannelDMC()
 	}
 
 	const float volume = dmc.outputLevel.Value();
-	dmc.sample = ( dmc.mute ? 0.0f : volume );
+	SetChannelSample( dmc.sample, ( dmc.mute ? 0.0f : volume ) );
 }
 
 
@@ -508,6 +604,8 @@ void APU::ExecFrameCounter()
 
 void APU::RunFrameClock( const bool halfClk, const bool quarterClk, const bool irq )
 {
+	frameClocked = true;
+
 	if ( halfClk )
 	{
 		ClockSweep( pulse1 );
@@ -556,33 +654,210 @@ void APU::RunFrameClock( const bool halfClk, const bool quarterClk, const bool i
 }
 
 
-bool APU::Step( const cpuCycle_t& nextCpuCycle )
+static FORCE_INLINE uint64_t CyclesToZero( const uint32_t counter, const uint64_t range )
 {
-	const apuCycle_t nextApuCycle = CpuToApuCycle( nextCpuCycle );
+	// Counters decrement before the zero check, so zero wraps through the full range
+	return ( counter == 0 ) ? range : counter;
+}
 
-	//dbgStartCycle		= apuCycle;
-	//dbgTargetCycle	= nextApuCycle;
-	//dbgSysStartCycle	= chrono::duration_cast<masterCycle_t>( dbgStartCycle );
-	//dbgSysTargetCycle	= chrono::duration_cast<masterCycle_t>( dbgTargetCycle );
 
-	while ( cpuCycle < nextCpuCycle )
+static FORCE_INLINE uint64_t AdvanceTimer( uint16_t& value, const uint32_t reload, const uint64_t ticks, const uint64_t range )
+{
+	// Returns how many times the timer reached zero and was reloaded over 'ticks'
+	const uint64_t toZero = CyclesToZero( value, range );
+	if ( ticks < toZero )
 	{
-		ExecFrameCounter();
-		ExecChannelTri();
-		ExecChannelDMC();
+		value = static_cast<uint16_t>( ( value - ticks ) & ( range - 1 ) );
+		return 0;
+	}
 
-		//apuCycle = chrono::duration_cast<apuCycle_t>( cpuCycle );
-		if ( ( cpuCycle.count() & 1 ) == 0 )
-		{
-			ExecPulseChannel( pulse1 );
-			ExecPulseChannel( pulse2 );
-			ExecChannelNoise();
-		}
+	const uint64_t period = CyclesToZero( reload & ( range - 1 ), range );
+	const uint64_t remaining = ticks - toZero;
+	value = static_cast<uint16_t>( ( reload - ( remaining % period ) ) & ( range - 1 ) );
+	return 1 + ( remaining / period );
+}
 
+
+bool APU::IsPulseSilent( PulseChannel& pulse )
+{
+	return ( pulse.lengthCounter == 0 ) || ( pulse.period.Value() < 8 ) || pulse.mute || pulse.sweep.mute || ( pulse.envelope.output == 0 );
+}
+
+
+bool APU::IsNoiseSilent()
+{
+	return ( noise.lengthCounter == 0 ) || noise.mute || ( noise.envelope.output == 0 );
+}
+
+
+bool APU::IsTriangleHalted()
+{
+	return ( triangle.lengthCounter == 0 ) || triangle.linearCounter.IsZero();
+}
+
+
+void APU::ExecCycle( const bool captureScope, const bool mixOutput )
+{
+	ExecFrameCounter();
+	ExecChannelTri();
+	ExecChannelDMC();
+
+	//apuCycle = chrono::duration_cast<apuCycle_t>( cpuCycle );
+	if ( ( cpuCycle.count() & 1 ) == 0 )
+	{
+		ExecPulseChannel( pulse1 );
+		ExecPulseChannel( pulse2 );
+		ExecChannelNoise();
+		frameClocked = false;
+	}
+
+#if DEBUG_APU_CHANNELS
+	if ( captureScope && outputChanged ) {
+		CaptureScope();
+	}
+#endif
+
+	// Only mix when a channel's level moved, the synth buffer holds it otherwise
+	if ( mixOutput && outputChanged ) {
 		Mixer();
+	}
 
-		++cpuCycle;
-		++frameSeqTick;
+	++cpuCycle;
+	++frameSeqTick;
+}
+
+
+cpuCycle_t APU::NextFrameSeqCycle() const
+{
+	// Same matches as ExecFrameCounter, a sequence that can't reach either tick never fires
+	const uint32_t mode = frameCounter.sem.mode;
+	const uint64_t tick = frameSeqTick.count();
+	const uint64_t eventTick = FrameSeqEvents[ frameSeqStep ][ mode ].cycle;
+	const uint64_t lastTick = FrameSeqEvents[ FrameSeqEventCnt - 1 ][ mode ].cycle;
+
+	uint64_t nextTick = ~0ull;
+	if ( eventTick >= tick ) {
+		nextTick = eventTick;
+	}
+
+	if ( ( lastTick >= tick ) && ( lastTick < nextTick ) ) {
+		nextTick = lastTick;
+	}
+
+	if ( nextTick == ~0ull ) {
+		return cpuCycle_t( ~0ull );
+	}
+
+	return cpuCycle + cpuCycle_t( nextTick - tick );
+}
+
+
+cpuCycle_t APU::NextEventCycle( const bool outputSilent )
+{
+	const uint64_t cycle = cpuCycle.count();
+	const uint64_t evenCycle = cycle + ( cycle & 1 );
+
+	// Timers of channels that can't change their output are stepped by SkipCycles instead,
+	// a silent channel only changes at a frame clock or a register write.
+	// Pulse and noise timers only count on even cycles.
+	uint64_t nextCycle = NextFrameSeqCycle().count();
+	nextCycle = std::min( nextCycle, cycle + CyclesToZero( dmc.periodCounter, 1ull << 16 ) - 1 );
+
+	// With no output every channel counts as silent, only the frame sequencer and the
+	// DMC reader can change state software sees ($4015, IRQs, sample fetches)
+	if ( outputSilent ) {
+		return cpuCycle_t( nextCycle );
+	}
+
+	if ( !IsTriangleHalted() ) {
+		nextCycle = std::min( nextCycle, cycle + CyclesToZero( triangle.timer.Value(), 1ull << 11 ) - 1 );
+	}
+
+	if ( !IsPulseSilent( pulse1 ) ) {
+		nextCycle = std::min( nextCycle, evenCycle + 2 * ( CyclesToZero( pulse1.periodTimer.Value(), 1ull << 12 ) - 1 ) );
+	}
+
+	if ( !IsPulseSilent( pulse2 ) ) {
+		nextCycle = std::min( nextCycle, evenCycle + 2 * ( CyclesToZero( pulse2.periodTimer.Value(), 1ull << 12 ) - 1 ) );
+	}
+
+	if ( !IsNoiseSilent() ) {
+		nextCycle = std::min( nextCycle, evenCycle + 2 * ( CyclesToZero( noise.timer.Value(), 1ull << 12 ) - 1 ) );
+	}
+
+	if ( frameClocked ) {
+		nextCycle = std::min( nextCycle, evenCycle );
+	}
+
+	return cpuCycle_t( nextCycle );
+}
+
+
+void APU::SkipCycles( const cpuCycle_t& targetCycle )
+{
+	// Only timers of silent channels reach zero before targetCycle (all of them when there is
+	// no output), and for those a reload just advances the sequence. Everything else is stepped in bulk.
+	const uint64_t cycles = ( targetCycle - cpuCycle ).count();
+	const uint64_t evenCycles = ( ( targetCycle.count() + 1 ) / 2 ) - ( ( cpuCycle.count() + 1 ) / 2 );
+
+	uint16_t timer = triangle.timer.Value();
+	const uint64_t triSteps = AdvanceTimer( timer, 1 + triangle.regTimer.sem0.timer, cycles, 1ull << 11 );
+	triangle.timer.Reload( timer );
+	if ( !IsTriangleHalted() ) {
+		triangle.sequenceStep = static_cast<uint8_t>( ( triangle.sequenceStep + triSteps ) % 32 );
+	}
+
+	dmc.periodCounter = static_cast<uint16_t>( dmc.periodCounter - cycles );
+
+	PulseChannel* pulses[] = { &pulse1, &pulse2 };
+	for ( PulseChannel* pulse : pulses )
+	{
+		timer = pulse->periodTimer.Value();
+		const uint64_t steps = AdvanceTimer( timer, pulse->period.Value() + 1, evenCycles, 1ull << 12 );
+		pulse->periodTimer.Reload( timer );
+		pulse->sequenceStep = static_cast<uint8_t>( ( pulse->sequenceStep + steps ) & 0x07 );
+	}
+
+	timer = noise.timer.Value();
+	const uint64_t shifts = AdvanceTimer( timer, NoiseLUT[ NTSC ][ noise.regFreq1.sem.period ], evenCycles, 1ull << 12 );
+	noise.timer.Reload( timer );
+	for ( uint64_t i = 0; i < shifts; ++i ) {
+		ClockNoiseShift();
+	}
+
+	cpuCycle = targetCycle;
+	frameSeqTick += cpuCycle_t( cycles );
+}
+
+
+bool APU::IsOutputSilent() const
+{
+	const config_t* config = system->GetConfig();
+	if ( ( config->sys.flags & emulationFlags_t::HEADLESS ) != 0 ) {
+		return true;
+	}
+
+	const config_t::APU& apuConfig = config->apu;
+	return apuConfig.mutePulse1 && apuConfig.mutePulse2 && apuConfig.muteTri && apuConfig.muteNoise && apuConfig.muteDMC;
+}
+
+
+bool APU::Step( const cpuCycle_t& nextCpuCycle )
+{
+	const bool outputSilent = IsOutputSilent();
+	const bool captureScope = ( scopeChannelBits != 0 );
+
+	// Register writes land between steps, so the first cycle always runs in full to pick
+	// them up. After that only cycles where a timer or the frame sequencer fires are run.
+	frameClocked = true;
+
+	while ( cpuCycle < nextCpuCycle )
+	{
+		ExecCycle( captureScope, !outputSilent );
+
+		if ( cpuCycle < nextCpuCycle ) {
+			SkipCycles( std::min( NextEventCycle( outputSilent ), nextCpuCycle ) );
+		}
 	}
 	apuCycle = CpuToApuCycle( cpuCycle );
 
@@ -590,14 +865,65 @@ bool APU::Step( const cpuCycle_t& nextCpuCycle )
 }
 
 
+cpuCycle_t APU::NextSyncCycle( syncEvent_t& event ) const
+{
+	// Returns the next APU cycle that can raise an IRQ, or ~0 when nothing is pending.
+	// DMC fetches read PRG directly and don't stall the CPU here, so only the IRQ matters.
+	cpuCycle_t nextCycle = cpuCycle_t( ~0ull );
+	event = SYNC_EVENT_COUNT;
+
+	if ( dmc.regCtrl.sem.irqEnable )
+	{
+		nextCycle = cpuCycle + cpuCycle_t( dmc.periodCounter - 1 );
+		event = SYNC_EVENT_DMC;
+	}
+
+	if ( frameCounter.sem.interrupt ) {
+		return nextCycle;
+	}
+
+	const uint32_t mode = frameCounter.sem.mode;
+
+	for ( uint32_t step = frameSeqStep; step < FrameSeqEventCnt; ++step )
+	{
+		const frameSeqEvent_t& seqEvent = FrameSeqEvents[ step ][ mode ];
+		if ( !seqEvent.irq || ( seqEvent.cycle < frameSeqTick.count() ) ) {
+			continue;
+		}
+
+		const cpuCycle_t irqCycle = cpuCycle + cpuCycle_t( seqEvent.cycle - frameSeqTick.count() );
+		if ( irqCycle < nextCycle )
+		{
+			nextCycle = irqCycle;
+			event = SYNC_EVENT_FRAME_IRQ;
+		}
+		break;
+	}
+
+	return nextCycle;
+}
+
+
 void APU::End()
 {
+	EndScope();
+
+	if ( IsOutputSilent() )
+	{
+		// Nothing was mixed, restart the synth here so output resumes without a backlog
+		synthStartCycle = cpuCycle;
+	}
+	else
+	{
+		// Picks up mute changes from the config even when no channel changed
+		Mixer();
+		FlushSynth();
+	}
+
 	frameOutput = soundOutput;
 
 	currentBuffer = ( currentBuffer + 1 ) % SoundBufferCnt;
 	soundOutput = &soundOutputBuffers[ currentBuffer ];
-
-	soundOutput->mixed.Reset();
 }
 
 
@@ -649,6 +975,7 @@ void APU::GetDebugInfo( apuDebug_t& apuDebug )
 
 void APU::Begin()
 {
+	BeginScope();
 }
 
 
@@ -658,6 +985,39 @@ void APU::RegisterSystem( wtSystem* sys )
 }
 
 
+void APU::SetChannelSample( float& sample, const float value )
+{
+	if ( sample != value )
+	{
+		sample = value;
+		outputChanged = true;
+	}
+}
+
+
+void APU::FlushSynth()
+{
+	int16_t samples[ wtBlipBuffer::BufferSize ];
+
+	// Deltas are only ever added inside the first span, longer runs just hold the level
+	uint32_t clocks = static_cast<uint32_t>( ( cpuCycle - synthStartCycle ).count() );
+	while ( clocks > 0 )
+	{
+		const uint32_t frameClocks = std::min( clocks, synth.GetMaxFrameClocks() );
+		const uint32_t sampleCnt = synth.EndFrame( frameClocks, samples );
+		audioRing.Write( samples, sampleCnt );
+		clocks -= frameClocks;
+	}
+	synthStartCycle = cpuCycle;
+}
+
+
+wtAudioRing& APU::GetAudioRing()
+{
+	return audioRing;
+}
+
+
 void APU::Mixer()
 {
 	const config_t::APU* config	= &system->GetConfig()->apu;
@@ -673,32 +1033,163 @@ void APU::Mixer()
 
 	assert( pulseMixed < 0.3f );
 
-	soundOutput->mixed.Enque( 32767.0f * mixedSample );
+	outputChanged = false;
 
-#if DEBUG_APU_CHANNELS
-	const float volumeScale = 1.0f;
-	if ( config->dbgChannelBits & 0x01 ) {
-		soundOutput->dbgMixed.EnqueFIFO( volumeScale * mixedSample );
+	const int32_t level = static_cast<int32_t>( 32767.0f * mixedSample );
+	if ( level == mixedLevel ) {
+		return;
+	}
+
+	if ( ( cpuCycle - synthStartCycle ).count() >= synth.GetMaxFrameClocks() ) {
+		FlushSynth();
 	}
-	if( config->dbgChannelBits & 0x02 ) {
-		const float pulseMixed = PulseMixer( (uint32_t)pulse1Sample, 0 );
-		soundOutput->dbgPulse1.EnqueFIFO( volumeScale * pulseMixed );
+
+	synth.AddDelta( static_cast<uint32_t>( ( cpuCycle - synthStartCycle ).count() ), level - mixedLevel );
+	mixedLevel = level;
+}
+
+
+void APU::GetScopeLevels( float* levels )
+{
+	const config_t::APU* config	= &system->GetConfig()->apu;
+	const uint32_t pulse1Sample	= ( config->mutePulse1	) ? 0 : static_cast<uint32_t>( pulse1.sample );
+	const uint32_t pulse2Sample	= ( config->mutePulse2	) ? 0 : static_cast<uint32_t>( pulse2.sample );
+	const uint32_t triSample	= ( config->muteTri		) ? 0 : static_cast<uint32_t>( triangle.sample );
+	const uint32_t noiseSample	= ( config->muteNoise	) ? 0 : static_cast<uint32_t>( noise.sample );
+	const uint32_t dmcSample	= ( config->muteDMC		) ? 0 : static_cast<uint32_t>( dmc.sample );
+
+	levels[ APU_SCOPE_MIXED ]	= PulseMixer( pulse1Sample, pulse2Sample ) + TndMixer( triSample, noiseSample, dmcSample );
+	levels[ APU_SCOPE_PULSE1 ]	= PulseMixer( pulse1Sample, 0 );
+	levels[ APU_SCOPE_PULSE2 ]	= PulseMixer( 0, pulse2Sample );
+	levels[ APU_SCOPE_TRI ]		= TndMixer( triSample, 0, 0 );
+	levels[ APU_SCOPE_NOISE ]	= TndMixer( 0, noiseSample, 0 );
+	levels[ APU_SCOPE_DMC ]		= TndMixer( 0, 0, dmcSample );
+}
+
+
+void APU::BeginScope()
+{
+	const config_t::APU* config = &system->GetConfig()->apu;
+
+	scopeStartCycle			= cpuCycle;
+	scopeBucketIx			= 0;
+	// Smaller buckets would run out before the frame ends and cut off the trace
+	scopeCyclesPerBucket	= static_cast<uint32_t>( std::max<int32_t>( ApuScopeMinBucketCycles, config->scopeCyclesPerBucket ) );
+	scopeChannelBits		= IsOutputSilent() ? 0 : config->dbgChannelBits;
+
+	soundOutput->bucketCnt			= 0;
+	soundOutput->cyclesPerBucket	= scopeCyclesPerBucket;
+	soundOutput->channelBits		= scopeChannelBits;
+
+	if ( scopeChannelBits == 0 ) {
+		return;
 	}
-	if ( config->dbgChannelBits & 0x04 ) {
-		const float pulseMixed = PulseMixer( 0, (uint32_t)pulse2Sample );
-		soundOutput->dbgPulse2.EnqueFIFO( volumeScale * pulseMixed );
+
+	GetScopeLevels( scopeLevel );
+	for ( uint32_t ch = 0; ch < APU_SCOPE_CHANNEL_COUNT; ++ch )
+	{
+		apuScopeTrace_t& trace = soundOutput->scope[ ch ];
+		trace.minLevel[ 0 ]	= scopeLevel[ ch ];
+		trace.maxLevel[ 0 ]	= scopeLevel[ ch ];
+		trace.triggerLevel	= scopeTriggerLevel[ ch ];
+		trace.triggerIx		= ~0u;
 	}
-	if ( config->dbgChannelBits & 0x08 ) {
-		const float triMixed = TndMixer( (uint32_t)triSample, 0, 0 );
-		soundOutput->dbgTri.EnqueFIFO( volumeScale * triMixed );
+}
+
+
+void APU::FillScope( const uint32_t bucketIx )
+{
+	// Buckets no level change landed in hold the last level
+	for ( uint32_t ch = 0; ch < APU_SCOPE_CHANNEL_COUNT; ++ch )
+	{
+		if ( ( scopeChannelBits & BIT_MASK( ch ) ) == 0 ) {
+			continue;
+		}
+
+		apuScopeTrace_t& trace = soundOutput->scope[ ch ];
+		for ( uint32_t i = scopeBucketIx + 1; i <= bucketIx; ++i )
+		{
+			trace.minLevel[ i ] = scopeLevel[ ch ];
+			trace.maxLevel[ i ] = scopeLevel[ ch ];
+		}
 	}
-	if ( config->dbgChannelBits & 0x10 ) {
-		const float noiseMixed = TndMixer( 0, (uint32_t)noiseSample, 0 );
-		soundOutput->dbgNoise.EnqueFIFO( volumeScale * noiseMixed );
+	scopeBucketIx = std::max( scopeBucketIx, bucketIx );
+}
+
+
+void APU::CaptureScope()
+{
+	// Channel levels only change on cycles that are executed, so recording just those
+	// changes gives the same envelope as sampling every cycle
+	const uint64_t scopeCycle = ( cpuCycle - scopeStartCycle ).count();
+	const uint32_t bucketIx = static_cast<uint32_t>( scopeCycle / scopeCyclesPerBucket );
+	if ( bucketIx >= ApuScopeBucketCnt ) {
+		return;
 	}
-	if ( config->dbgChannelBits & 0x20 ) {
-		const float dmcMixed = TndMixer( 0, 0, (uint32_t)dmcSample );
-		soundOutput->dbgDmc.EnqueFIFO( volumeScale * dmcMixed );
+
+	// The held level never lasted a cycle into a bucket this starts
+	const bool bucketStart = ( ( scopeCycle % scopeCyclesPerBucket ) == 0 );
+
+	FillScope( bucketIx );
+
+	float levels[ APU_SCOPE_CHANNEL_COUNT ];
+	GetScopeLevels( levels );
+
+	for ( uint32_t ch = 0; ch < APU_SCOPE_CHANNEL_COUNT; ++ch )
+	{
+		if ( ( scopeChannelBits & BIT_MASK( ch ) ) == 0 ) {
+			continue;
+		}
+
+		apuScopeTrace_t& trace = soundOutput->scope[ ch ];
+		const float level = levels[ ch ];
+		if ( ( trace.triggerIx == ~0u ) && ( scopeLevel[ ch ] <= trace.triggerLevel ) && ( level > trace.triggerLevel ) ) {
+			trace.triggerIx = bucketIx;
+		}
+
+		trace.minLevel[ bucketIx ] = bucketStart ? level : std::min( trace.minLevel[ bucketIx ], level );
+		trace.maxLevel[ bucketIx ] = bucketStart ? level : std::max( trace.maxLevel[ bucketIx ], level );
+		scopeLevel[ ch ] = level;
 	}
-#endif
-}
\ No newline at end of file
+}
+
+
+void APU::EndScope()
+{
+	if ( scopeChannelBits == 0 ) {
+		return;
+	}
+
+	const uint64_t cycles = ( cpuCycle - scopeStartCycle ).count();
+	const uint32_t bucketCnt = static_cast<uint32_t>( std::min<uint64_t>( ( cycles + scopeCyclesPerBucket - 1 ) / scopeCyclesPerBucket, ApuScopeBucketCnt ) );
+	if ( bucketCnt == 0 ) {
+		return;
+	}
+
+	FillScope( bucketCnt - 1 );
+	soundOutput->bucketCnt = bucketCnt;
+
+	for ( uint32_t ch = 0; ch < APU_SCOPE_CHANNEL_COUNT; ++ch )
+	{
+		if ( ( scopeChannelBits & BIT_MASK( ch ) ) == 0 ) {
+			continue;
+		}
+
+		apuScopeTrace_t& trace = soundOutput->scope[ ch ];
+
+		// Free run when no edge leaves a full window to display
+		if ( ( trace.triggerIx == ~0u ) || ( ( trace.triggerIx + ApuScopeWindowCnt ) > bucketCnt ) ) {
+			trace.triggerIx = 0;
+		}
+
+		// Auto level, the next frame triggers halfway between this frame's extremes
+		float minLevel = trace.minLevel[ 0 ];
+		float maxLevel = trace.maxLevel[ 0 ];
+		for ( uint32_t i = 1; i < bucketCnt; ++i )
+		{
+			minLevel = std::min( minLevel, trace.minLevel[ i ] );
+			maxLevel = std::max( maxLevel, trace.maxLevel[ i ] );
+		}
+		scopeTriggerLevel[ ch ] = 0.5f * ( minLevel + maxLevel );
+	}
+}
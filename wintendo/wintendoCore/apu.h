@@ -9,6 +9,12 @@ class wtSystem;
 static constexpr uint32_t	ApuSamplesPerSec	= static_cast<uint32_t>( CPU_HZ + 1 );
 static constexpr uint32_t	ApuBufferMs			= static_cast<uint32_t>( 1000.0f / MinFPS );
 static constexpr uint32_t	ApuBufferSize		= static_cast<uint32_t>( ApuSamplesPerSec *  ( ApuBufferMs / 1000.0f ) );
+static constexpr uint32_t	ApuOutputHz			= 48000;
+static constexpr uint32_t	ApuOutputBufferSize	= static_cast<uint32_t>( ApuOutputHz * ( ApuBufferMs / 1000.0f ) );
+static constexpr uint32_t	ApuRingSize			= 16384; // ~340ms at ApuOutputHz
+static constexpr uint32_t	ApuScopeBucketCnt	= 2048; // A full frame at ApuScopeMinBucketCycles or more per bucket
+static constexpr uint32_t	ApuScopeMinBucketCycles	= 16; // 2048 buckets cover a frame's ~29781 CPU cycles with room for a long epoch
+static constexpr uint32_t	ApuScopeWindowCnt	= 256; // Buckets displayed from the trigger
 
 #define DEBUG_APU_CHANNELS 1
 
@@ -43,6 +49,7 @@ static const uint16_t DmcLUT[ ANALOG_MODE_COUNT ][ 16 ] =
 
 using wtSampleQueue = wtQueue< float, ApuBufferSize >;
 using wtSoundBuffer = wtBuffer< float, ApuBufferSize >;
+using wtAudioRing = wtSpscRing< int16_t, ApuRingSize >;
 
 union pulseCtrl_t
 {
@@ -440,15 +447,66 @@ static const uint8_t PulseLUT[4][8] =
 };
 
 
+// Band-limited step synthesis (blip_buf style). The mixer adds amplitude deltas at CPU cycle
+// times when the output changes and samples are produced directly at ApuOutputHz.
+class wtBlipBuffer
+{
+public:
+	static const uint32_t KernelTaps	= 16;
+	static const uint32_t KernelPhases	= 64;
+	static const uint32_t PhaseBits		= 6;
+	static const uint32_t FracBits		= 32;
+	static const uint32_t KernelBits	= 15;
+	static const uint32_t BufferSize	= ApuOutputBufferSize + KernelTaps;
+
+	void		Init( const double clockHz, const double sampleHz );
+	void		Clear();
+	void		AddDelta( const uint32_t clockTime, const int32_t delta );
+	uint32_t	EndFrame( const uint32_t clockDuration, int16_t* output );
+
+	uint32_t	GetMaxFrameClocks() const
+	{
+		return maxFrameClocks;
+	}
+
+private:
+	uint64_t	factor;			// Output samples per clock, FracBits fixed point
+	uint64_t	offset;			// Fractional output position of the frame start
+	uint32_t	maxFrameClocks;
+	int64_t		integrator;
+	int64_t		buffer[ BufferSize ];
+	int32_t		kernel[ KernelPhases ][ KernelTaps ];
+};
+
+
+enum apuScopeChannel_t : uint8_t
+{
+	APU_SCOPE_MIXED,
+	APU_SCOPE_PULSE1,
+	APU_SCOPE_PULSE2,
+	APU_SCOPE_TRI,
+	APU_SCOPE_NOISE,
+	APU_SCOPE_DMC,
+	APU_SCOPE_CHANNEL_COUNT,
+};
+
+
+struct apuScopeTrace_t
+{
+	float		minLevel[ ApuScopeBucketCnt ];
+	float		maxLevel[ ApuScopeBucketCnt ];
+	float		triggerLevel;
+	uint32_t	triggerIx; // First bucket with a rising edge through triggerLevel, 0 when free running
+};
+
+
+// One frame of oscilloscope capture, each bucket holds a channel's min/max level over cyclesPerBucket cycles
 struct apuOutput_t
 {
-	wtSampleQueue	dbgMixed;
-	wtSampleQueue	dbgPulse1;
-	wtSampleQueue	dbgPulse2;
-	wtSampleQueue	dbgTri;
-	wtSampleQueue	dbgNoise;
-	wtSampleQueue	dbgDmc;
-	wtSampleQueue	mixed;
+	apuScopeTrace_t	scope[ APU_SCOPE_CHANNEL_COUNT ];
+	uint32_t		bucketCnt;
+	uint32_t		cyclesPerBucket;
+	uint8_t			channelBits; // Traces captured this frame, bit n is apuScopeChannel_t n
 };
 
 
@@ -490,6 +548,7 @@ private:
 	cpuCycle_t		frameSeqTick;
 	uint8_t			frameSeqStep;
 	uint8_t			frameSeq;
+	bool			frameClocked; // Pulse and noise levels need recomputing on their next cycle
 
 	apuCycle_t		dbgStartCycle;
 	apuCycle_t		dbgTargetCycle;
@@ -506,6 +565,19 @@ private:
 	float			squareLUT[SquareLutEntries];
 	float			tndLUT[TndLutEntries];
 
+	wtBlipBuffer	synth;
+	wtAudioRing		audioRing; // Output samples at ApuOutputHz, read by the host's audio thread
+	cpuCycle_t		synthStartCycle;
+	int32_t			mixedLevel;
+	bool			outputChanged;
+
+	cpuCycle_t		scopeStartCycle;
+	uint32_t		scopeBucketIx; // Last bucket written, later ones still hold scopeLevel
+	uint32_t		scopeCyclesPerBucket;
+	uint8_t			scopeChannelBits;
+	float			scopeLevel[ APU_SCOPE_CHANNEL_COUNT ];
+	float			scopeTriggerLevel[ APU_SCOPE_CHANNEL_COUNT ];
+
 	uint32_t		currentBuffer;
 	apuOutput_t*	soundOutput;
 	apuOutput_t		soundOutputBuffers[ SoundBufferCnt ];
@@ -518,6 +590,7 @@ public:
 	{
 		Reset();
 		InitMixerLUT();
+		synth.Init( CPU_HZ, ApuOutputHz );
 	}
 
 	void Reset()
@@ -536,6 +609,7 @@ public:
 		pulse2.channelNum	= PULSE_2;
 
 		frameSeqStep		= 0;
+		frameClocked		= true;
 		frameCounter.byte	= 0;
 		currentBuffer		= 0;
 		soundOutput			= &soundOutputBuffers[0];
@@ -549,15 +623,26 @@ public:
 		frameSeqTick		= cpuCycle_t( 0 );
 		frameOutput			= nullptr;
 
+		synth.Clear();
+		synthStartCycle		= cpuCycle_t( 0 );
+		mixedLevel			= 0;
+		outputChanged		= false;
+
+		scopeStartCycle		= cpuCycle_t( 0 );
+		scopeBucketIx		= 0;
+		scopeCyclesPerBucket = 1;
+		scopeChannelBits	= 0;
+		for ( uint32_t i = 0; i < APU_SCOPE_CHANNEL_COUNT; ++i )
+		{
+			scopeLevel[i] = 0.0f;
+			scopeTriggerLevel[i] = 0.0f;
+		}
+
 		for ( uint32_t i = 0; i < SoundBufferCnt; ++i )
 		{
-			soundOutputBuffers[i].mixed.Reset();
-			soundOutputBuffers[i].dbgPulse1.Reset();
-			soundOutputBuffers[i].dbgPulse2.Reset();
-			soundOutputBuffers[i].dbgTri.Reset();
-			soundOutputBuffers[i].dbgNoise.Reset();
-			soundOutputBuffers[i].dbgDmc.Reset();
-			soundOutputBuffers[i].dbgMixed.Reset();
+			soundOutputBuffers[i].bucketCnt = 0;
+			soundOutputBuffers[i].cyclesPerBucket = 1;
+			soundOutputBuffers[i].channelBits = 0;
 		}
 
 		system = nullptr;
@@ -568,6 +653,7 @@ public:
 	void		RegisterSystem( wtSystem* system );
 
 	bool		Step( const cpuCycle_t& nextCpuCycle );
+	cpuCycle_t	NextSyncCycle( syncEvent_t& event ) const;
 	void		End();
 	void		WriteReg( const uint16_t addr, const uint8_t value );
 	uint8_t		ReadReg( const uint16_t addr );
@@ -576,13 +662,23 @@ public:
 	float		GetPulsePeriod( PulseChannel& pulse );
 	void		GetDebugInfo( apuDebug_t& apuDebug );
 	void		SampleDmcBuffer();
+	wtAudioRing&	GetAudioRing();
 
 	void		Serialize( Serializer& serializer );
 
 private:
+	void		ExecCycle( const bool captureScope, const bool mixOutput );
+	void		SkipCycles( const cpuCycle_t& targetCycle );
+	cpuCycle_t	NextEventCycle( const bool outputSilent );
+	bool		IsOutputSilent() const;
+	cpuCycle_t	NextFrameSeqCycle() const;
+	bool		IsPulseSilent( PulseChannel& pulse );
+	bool		IsNoiseSilent();
+	bool		IsTriangleHalted();
 	void		ExecPulseChannel( PulseChannel& pulse );
 	void		ExecChannelTri();
 	void		ExecChannelNoise();
+	void		ClockNoiseShift();
 	void		ExecChannelDMC();
 	void		ExecFrameCounter();
 	void		ClockEnvelope( envelope_t& envelope, const uint8_t volume, const bool loop, const bool constant );
@@ -593,4 +689,11 @@ private:
 	float		PulseMixer( const uint32_t pulse1, const uint32_t pulse2 );
 	float		TndMixer( const uint32_t triangle, const uint32_t noise, const uint32_t dmc );
 	void		ClockDmc();
+	void		SetChannelSample( float& sample, const float value );
+	void		FlushSynth();
+	void		GetScopeLevels( float* levels );
+	void		BeginScope();
+	void		FillScope( const uint32_t bucketIx );
+	void		CaptureScope();
+	void		EndScope();
 };
\ No newline at end of file
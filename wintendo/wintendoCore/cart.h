@@ -47,13 +47,12 @@ public:
 	virtual uint8_t			OnLoadCpu() { return 0; };
 	virtual uint8_t			OnLoadPpu() { return 0; };
 	virtual uint8_t			ReadRom( const uint16_t addr ) const = 0;
-	virtual uint8_t			ReadChrRom( const uint16_t addr ) const { return 0; };
-	virtual uint8_t			WriteChrRam( const uint16_t addr, const uint8_t value ) { return 0; };
 	virtual uint8_t			Write( const uint16_t addr, const uint8_t value ) { return 0; };
 	virtual bool			InWriteWindow( const uint16_t addr, const uint16_t offset ) const { return false; };
 
 	virtual void			Serialize( Serializer& serializer ) {};
 	virtual void			Clock() {};
+	virtual bool			IrqEnabled() const { return false; };
 };
 
 
@@ -67,6 +67,35 @@ void wtSystem::ProcessCommands()
 			}
 			break;
 
+			case sysCmdType_t::START_PROFILE:
+			{
+				cpu.profiler.Start( KB( 16 ) * cart->h.prgRomBanks );
+			}
+			break;
+
+			case sysCmdType_t::STOP_PROFILE:
+			{
+				cpu.profiler.Stop();
+			}
+			break;
+
+			case sysCmdType_t::START_VRAM_HEATMAP:
+			{
+				if ( vramHeatmap == nullptr ) {
+					vramHeatmap = unique_ptr<wtVramHeatmap>( new wtVramHeatmap() );
+					ppu.AttachVramHeatmap( vramHeatmap.get() );
+				}
+			}
+			break;
+
+			case sysCmdType_t::STOP_VRAM_HEATMAP:
+			{
+				ppu.AttachVramHeatmap( nullptr );
+				vramHeatmap.reset();
+				vramHeatmapImage.Clear();
+			}
+			break;
+
 			default: break;
 		}
 		commands.pop_front();
@@ -9,6 +9,10 @@ enum class sysCmdType_t
 	REPLAY,
 	START_TRACE,
 	STOP_TRACE,
+	START_PROFILE,
+	STOP_PROFILE,
+	START_VRAM_HEATMAP,
+	STOP_VRAM_HEATMAP,
 };
 
 struct sysCmd_t
@@ -14,7 +14,9 @@
 #define NES_MODE			(1)
 #define DEBUG_MODE			(0)
 #define DEBUG_ADDR			(1)
-#define MIRROR_OPTIMIZATION	(1)
+#define CPU_SWITCH_DISPATCH	(1) // 0: dispatch through opLUT function pointers
+#define PPU_SCANLINE_RENDER	(1) // 0: always step the PPU dot-by-dot
+#define PPU_COMPOSITE_SIMD	(1) // 0: scalar reference, 1: SSE2, 2: AVX2 (build with /arch:AVX2)
 
 const uint32_t KB_1		= 1024;
 const uint32_t MB_1		= 1024 * KB_1;
@@ -57,6 +59,21 @@ enum analogMode_t
 	ANALOG_MODE_COUNT,
 };
 
+enum syncEvent_t : uint8_t
+{
+	SYNC_EVENT_NMI,
+	SYNC_EVENT_MAPPER_IRQ,
+	SYNC_EVENT_FRAME_IRQ,
+	SYNC_EVENT_DMC,
+	SYNC_EVENT_FRAME_STATE,
+	SYNC_EVENT_EPOCH,
+	SYNC_EVENT_PPU_REG,
+	SYNC_EVENT_APU_REG,
+	SYNC_EVENT_MAPPER_REG,
+	SYNC_EVENT_TRACE,
+	SYNC_EVENT_COUNT,
+};
+
 struct debugTiming_t
 {
 	uint32_t		frameTimeUs;
@@ -69,6 +86,8 @@ struct debugTiming_t
 	masterCycle_t	cycleBegin;
 	masterCycle_t	cycleEnd;
 	masterCycle_t	stateCycle;
+	uint32_t		syncCount[ SYNC_EVENT_COUNT ];
+	uint32_t		skippedCycles; // CPU cycles fast-forwarded through idle loops
 };
 
 
@@ -107,6 +126,7 @@ struct config_t
 		bool				muteNoise;
 		bool				muteDMC;
 		uint8_t				dbgChannelBits;
+		int32_t				scopeCyclesPerBucket;
 	} apu;
 
 	struct PPU
@@ -115,6 +135,8 @@ struct config_t
 		int32_t				spriteLimit;
 		bool				showBG;
 		bool				showSprite;
+		bool				indexedFrameBuffer; // Output palette indices, expanded with wtSystem::ExpandFrameBuffer
+		bool				spriteIdBuffer; // Record the OAM index drawn at each pixel, used for sprite picking
 	} ppu;
 };
 
@@ -230,6 +252,11 @@ public:
 		return &buffer[0].rawABGR;
 	}
 
+	inline uint32_t* GetRawBuffer()
+	{
+		return &buffer[0].rawABGR;
+	}
+
 	inline uint32_t GetWidth() const
 	{
 		return width;
@@ -263,12 +290,90 @@ private:
 	const char* name;
 };
 
+// One byte per pixel holding a 6-bit NES palette index. PPUMASK emphasis doesn't fit
+// alongside it and games only change it between lines, so it is stored once per line.
+template< uint32_t N, uint32 M >
+class wtIndexedImage
+{
+public:
+
+	wtIndexedImage()
+	{
+		Clear();
+	}
+
+	FORCE_INLINE void Set( const uint32_t index, const uint8_t value )
+	{
+		assert( index < length );
+		buffer[ index ] = value;
+	}
+
+	inline uint8_t Get( const uint32_t index ) const
+	{
+		assert( index < length );
+		return buffer[ index ];
+	}
+
+	inline void SetEmphasis( const uint32_t y, const uint8_t emphasisBits )
+	{
+		assert( y < height );
+		emphasis[ y ] = emphasisBits;
+	}
+
+	inline uint8_t GetEmphasis( const uint32_t y ) const
+	{
+		assert( y < height );
+		return emphasis[ y ];
+	}
+
+	void Clear( const uint8_t value = 0 )
+	{
+		memset( buffer, value, length );
+		memset( emphasis, 0, height );
+	}
+
+	inline const uint8_t* GetRawBuffer() const
+	{
+		return &buffer[ 0 ];
+	}
+
+	inline uint8_t* GetRawBuffer()
+	{
+		return &buffer[ 0 ];
+	}
+
+	inline uint32_t GetWidth() const
+	{
+		return width;
+	}
+
+	inline uint32_t GetHeight() const
+	{
+		return height;
+	}
+
+	inline uint32_t GetBufferLength() const
+	{
+		return length;
+	}
+
+private:
+	static const uint32_t width = N;
+	static const uint32_t height = M;
+	static const uint32_t length = N * M;
+	uint8_t buffer[ length ];
+	uint8_t emphasis[ height ];
+};
+
 using wtDisplayImage = wtRawImage<256, 240>;
+using wtIndexedDisplayImage = wtIndexedImage<256, 240>;
+using wtSpriteIdImage = wtIndexedImage<256, 240>; // OAM index per pixel, PPU::NoSpriteId where no sprite drew
 using wtNameTableImage = wtRawImage<2 * 256, 2 *240>;
 using wtPaletteImage = wtRawImage<16, 2>;
 using wtPatternTableImage = wtRawImage<128, 128>;
 using wt16x8ChrImage = wtRawImage<8, 16>;
 using wt8x8ChrImage = wtRawImage<8, 8>;
+using wtVramHeatmapImage = wtRawImage<128, 128>;
 
 enum class wtImageTag
 {
@@ -278,4 +278,154 @@ void wtLog::ToString( std::string& buffer, const uint32_t frameBegin, const uint
 			buffer += "\n";
 		}
 	}
-}
\ No newline at end of file
+}
+
+
+void wtLog::CountOpPairs( opPairHistogram_t& histogram, const uint32_t frameBegin, const uint32_t frameEnd ) const
+{
+	const OpDebugInfo* prevInfo = nullptr;
+	for( uint32_t i = ( frameBegin + 1 ); i <= frameEnd; ++i )
+	{
+		for ( const OpDebugInfo& dbgInfo : GetLogFrame( i ) )
+		{
+			// Interrupts break up the instruction stream, no pair spans one
+			if ( dbgInfo.nmi || dbgInfo.irq )
+			{
+				prevInfo = nullptr;
+				continue;
+			}
+
+			if ( prevInfo != nullptr )
+			{
+				opPairCount_t& pair = histogram[ ( prevInfo->byteCode << 8 ) | dbgInfo.byteCode ];
+				pair.first = prevInfo->mnemonic;
+				pair.second = dbgInfo.mnemonic;
+				++pair.count;
+			}
+			prevInfo = &dbgInfo;
+		}
+	}
+}
+
+
+void wtProfiler::Reset()
+{
+	const profileStat_t emptyStats = { 0, 0 };
+	addressStats.clear();
+	prgStats.clear();
+	for ( uint32_t i = 0; i < OpCodeCount; ++i ) {
+		opStats[ i ] = emptyStats;
+	}
+	for ( uint32_t i = 0; i < AddrModeCount; ++i ) {
+		addrModeStats[ i ] = emptyStats;
+	}
+	totalStats = emptyStats;
+}
+
+
+void wtProfiler::Start( const uint32_t prgRomSize )
+{
+	const profileStat_t emptyStats = { 0, 0 };
+	Reset();
+	addressStats.assign( AddressCount, emptyStats );
+	prgStats.assign( prgRomSize, emptyStats );
+	enabled = true;
+}
+
+
+void wtProfiler::Stop()
+{
+	enabled = false;
+}
+
+
+bool wtProfiler::IsEnabled() const
+{
+	return enabled;
+}
+
+
+bool wtProfiler::HasSamples() const
+{
+	return ( totalStats.count > 0 );
+}
+
+
+uint32_t wtProfiler::GetPrgSize() const
+{
+	return static_cast<uint32_t>( prgStats.size() );
+}
+
+
+const profileStat_t& wtProfiler::GetTotalStats() const
+{
+	return totalStats;
+}
+
+
+const profileStat_t& wtProfiler::GetOpStats( const uint8_t opCode ) const
+{
+	return opStats[ opCode ];
+}
+
+
+const profileStat_t& wtProfiler::GetAddrModeStats( const uint8_t addrMode ) const
+{
+	return addrModeStats[ addrMode % AddrModeCount ];
+}
+
+
+const profileStat_t& wtProfiler::GetAddressStats( const uint16_t address ) const
+{
+	assert( address < addressStats.size() );
+	return addressStats[ address ];
+}
+
+
+const profileStat_t& wtProfiler::GetPrgStats( const uint32_t prgOffset ) const
+{
+	assert( prgOffset < prgStats.size() );
+	return prgStats[ prgOffset ];
+}
+
+void wtVramHeatmap::Reset()
+{
+	memset( writes, 0, sizeof( writes ) );
+	memset( frameWrites, 0, sizeof( frameWrites ) );
+	frameMaxWrites = 0;
+}
+
+
+void wtVramHeatmap::EndFrame()
+{
+	frameMaxWrites = 0;
+	for ( uint32_t i = 0; i < AddressCount; ++i ) {
+		if ( writes[ i ] > frameMaxWrites ) {
+			frameMaxWrites = writes[ i ];
+		}
+	}
+	memcpy( frameWrites, writes, sizeof( writes ) );
+	memset( writes, 0, sizeof( writes ) );
+}
+
+
+void wtVramHeatmap::DrawImage( wtRawImageInterface& image ) const
+{
+	assert( image.GetBufferLength() >= AddressCount );
+
+	// One pixel per address, rows of 128 bytes so each 1KB page is 8 rows.
+	// Unwritten addresses are black, written ones ramp from red to yellow relative to the busiest address.
+	for ( uint32_t addr = 0; addr < AddressCount; ++addr )
+	{
+		Pixel pixel;
+		pixel.rawABGR = 0xFF000000;
+		if ( frameWrites[ addr ] > 0 )
+		{
+			const uint32_t heat = ( 255 * frameWrites[ addr ] ) / frameMaxWrites;
+			pixel.rgba.red = 255;
+			pixel.rgba.green = static_cast<uint8_t>( heat );
+			pixel.rgba.blue = 0;
+		}
+		image.Set( addr, pixel );
+	}
+}
@@ -2,12 +2,13 @@
 
 #include <string>
 #include <sstream>
+#include <vector>
 
 #include "common.h"
 
 #if DEBUG_ADDR == 1
 #define DEBUG_ADDR_INDEXED_ZERO( _info )												\
-	if( IsTraceLogOpen() )																\
+	if( Traced && IsTraceLogOpen() )													\
 	{																					\
 		OpDebugInfo& dbgInfo	= dbgLog.GetLogLine();									\
 		dbgInfo.address			= _info.addr;											\
@@ -16,7 +17,7 @@
 	}
 
 #define DEBUG_ADDR_INDEXED_ABS( _info )													\
-	if( IsTraceLogOpen() )																\
+	if( Traced && IsTraceLogOpen() )													\
 	{																					\
 		OpDebugInfo& dbgInfo	= dbgLog.GetLogLine();									\
 		dbgInfo.address			= _info.addr;											\
@@ -25,7 +26,7 @@
 	}
 
 #define DEBUG_ADDR_ZERO( _info )														\
-	if( cpu.IsTraceLogOpen() )															\
+	if( Traced && cpu.IsTraceLogOpen() )												\
 	{																					\
 		OpDebugInfo& dbgInfo	= cpu.dbgLog.GetLogLine();								\
 		dbgInfo.address			= _info.addr;											\
@@ -33,7 +34,7 @@
 	}
 
 #define DEBUG_ADDR_ABS( _info )															\
-	if( cpu.IsTraceLogOpen() )															\
+	if( Traced && cpu.IsTraceLogOpen() )												\
 	{																					\
 		OpDebugInfo& dbgInfo	= cpu.dbgLog.GetLogLine();								\
 		dbgInfo.address			= _info.addr;											\
@@ -41,7 +42,7 @@
 	}
 
 #define DEBUG_ADDR_IMMEDIATE( _info )													\
-	if( cpu.IsTraceLogOpen() )															\
+	if( Traced && cpu.IsTraceLogOpen() )												\
 	{																					\
 		OpDebugInfo& dbgInfo	= cpu.dbgLog.GetLogLine();								\
 		dbgInfo.address			= _info.addr;											\
@@ -49,7 +50,7 @@
 	}
 
 #define DEBUG_ADDR_INDIRECT_INDEXED( _info )											\
-	if( cpu.IsTraceLogOpen() )															\
+	if( Traced && cpu.IsTraceLogOpen() )												\
 	{																					\
 		OpDebugInfo& dbgInfo	= cpu.dbgLog.GetLogLine();								\
 		dbgInfo.address			= _info.addr;											\
@@ -59,7 +60,7 @@
 	}
 
 #define DEBUG_ADDR_INDEXED_INDIRECT( _info )											\
-	if( cpu.IsTraceLogOpen() )															\
+	if( Traced && cpu.IsTraceLogOpen() )												\
 	{																					\
 		OpDebugInfo& dbgInfo	= cpu.dbgLog.GetLogLine();								\
 		dbgInfo.address			= _info.addr;											\
@@ -68,19 +69,19 @@
 	}
 
 #define DEBUG_ADDR_ACCUMULATOR( _info )													\
-	if( cpu.IsTraceLogOpen() )															\
+	if( Traced && cpu.IsTraceLogOpen() )												\
 	{																					\
 	}
 
 #define DEBUG_ADDR_JMP( _PC )															\
-	if( IsTraceLogOpen() )																\
+	if( AddrModeT::traced && IsTraceLogOpen() )											\
 	{																					\
 		OpDebugInfo& dbgInfo	= dbgLog.GetLogLine();									\
 		dbgInfo.address			= _PC;													\
 	}
 
 #define DEBUG_ADDR_JMPI( _offset, _PC )													\
-	if( IsTraceLogOpen() )																\
+	if( AddrModeT::traced && IsTraceLogOpen() )											\
 	{																					\
 		OpDebugInfo& dbgInfo	= dbgLog.GetLogLine();									\
 		dbgInfo.offset			= _offset;												\
@@ -88,14 +89,14 @@
 	}
 
 #define DEBUG_ADDR_JSR( _PC )															\
-	if( IsTraceLogOpen() )																\
+	if( AddrModeT::traced && IsTraceLogOpen() )											\
 	{																					\
 		OpDebugInfo& dbgInfo	= dbgLog.GetLogLine();									\
 		dbgInfo.address			= _PC;													\
 	}
 
 #define DEBUG_ADDR_BRANCH( _PC )														\
-	if( IsTraceLogOpen() )																\
+	if( Traced && IsTraceLogOpen() )													\
 	{																					\
 		OpDebugInfo& dbgInfo	= dbgLog.GetLogLine();									\
 		dbgInfo.address			= _PC;													\
@@ -199,8 +200,16 @@ public:
 	void ToString( std::string& buffer, const bool registerDebug = true, const bool cycleDebug = true ) const;
 };
 
+struct opPairCount_t
+{
+	const char*		first;
+	const char*		second;
+	uint32_t		count;
+};
+
 using logFrame_t = std::vector<OpDebugInfo>;
 using logRecords_t = std::vector<logFrame_t>;
+using opPairHistogram_t = std::map<uint16_t, opPairCount_t>; // Keyed by ( firstOp << 8 ) | secondOp
 
 class wtLog
 {
@@ -224,4 +233,114 @@ public:
 	bool				IsFull() const;
 	bool				IsFinished() const;
 	void				ToString( std::string& buffer, const uint32_t frameBegin, const uint32_t frameEnd, const bool registerDebug = true ) const;
-};
\ No newline at end of file
+	void				CountOpPairs( opPairHistogram_t& histogram, const uint32_t frameBegin, const uint32_t frameEnd ) const;
+};
+
+
+struct profileStat_t
+{
+	uint64_t		count;
+	uint64_t		cycles;
+};
+
+
+class wtProfiler
+{
+public:
+	static const uint32_t AddressCount	= 0x10000;
+	static const uint32_t OpCodeCount	= 256;
+	static const uint32_t AddrModeCount	= 16; // Number of addrMode_t values
+
+private:
+	std::vector<profileStat_t>	addressStats;	// Indexed by CPU address
+	std::vector<profileStat_t>	prgStats;		// Indexed by PRG-ROM offset, so banks are kept apart
+	profileStat_t				opStats[ OpCodeCount ];
+	profileStat_t				addrModeStats[ AddrModeCount ];
+	profileStat_t				totalStats;
+	bool						enabled;
+
+	static FORCE_INLINE void Accumulate( profileStat_t& stats, const uint64_t cycles )
+	{
+		++stats.count;
+		stats.cycles += cycles;
+	}
+
+	void Reset();
+
+public:
+	wtProfiler() : enabled( false )
+	{
+		Reset();
+	}
+
+	void					Start( const uint32_t prgRomSize );
+	void					Stop();
+	bool					IsEnabled() const;
+	bool					HasSamples() const;
+	uint32_t				GetPrgSize() const;
+	const profileStat_t&	GetTotalStats() const;
+	const profileStat_t&	GetOpStats( const uint8_t opCode ) const;
+	const profileStat_t&	GetAddrModeStats( const uint8_t addrMode ) const;
+	const profileStat_t&	GetAddressStats( const uint16_t address ) const;
+	const profileStat_t&	GetPrgStats( const uint32_t prgOffset ) const;
+
+	// prgOffset is negative for code running outside PRG-ROM
+	FORCE_INLINE void Record( const uint16_t address, const int32_t prgOffset, const uint8_t opCode, const uint8_t addrMode, const uint64_t cycles )
+	{
+		Accumulate( totalStats, cycles );
+		Accumulate( opStats[ opCode ], cycles );
+		Accumulate( addrModeStats[ addrMode % AddrModeCount ], cycles );
+		Accumulate( addressStats[ address ], cycles );
+		if ( ( prgOffset >= 0 ) && ( static_cast<uint32_t>( prgOffset ) < prgStats.size() ) ) {
+			Accumulate( prgStats[ prgOffset ], cycles );
+		}
+	}
+};
+
+struct profileHotSpot_t
+{
+	int32_t			bank; // -1 for code outside PRG-ROM
+	uint32_t		address;
+	profileStat_t	stats;
+};
+
+// Copy of the profiler results taken on the emulator thread, the live profiler keeps changing while the CPU runs
+struct profileSnapshot_t
+{
+	static const uint32_t MaxHotSpots = 256;
+
+	profileStat_t		totalStats;
+	profileStat_t		opStats[ wtProfiler::OpCodeCount ];
+	profileStat_t		addrModeStats[ wtProfiler::AddrModeCount ];
+	profileHotSpot_t	hotSpots[ MaxHotSpots ];	// Sorted by cycles
+	uint32_t			hotSpotCount;
+};
+
+// PPU-side VRAM write counts over $0000-$3FFF, attached to the PPU only while the debugger shows them
+class wtVramHeatmap
+{
+public:
+	static const uint32_t AddressCount	= 0x4000;
+	static const uint32_t ImageWidth	= 128;
+	static const uint32_t ImageHeight	= AddressCount / ImageWidth;
+
+private:
+	uint32_t	writes[ AddressCount ];		// Frame in progress
+	uint32_t	frameWrites[ AddressCount ];	// Last finished frame
+	uint32_t	frameMaxWrites;
+
+public:
+	wtVramHeatmap()
+	{
+		Reset();
+	}
+
+	void		Reset();
+	void		EndFrame();
+	void		DrawImage( wtRawImageInterface& image ) const;
+
+	FORCE_INLINE void Record( const uint16_t address )
+	{
+		++writes[ address % AddressCount ];
+	}
+};
@@ -69,6 +69,22 @@ private:
 		}
 	}
 
+	void MapChrBanks()
+	{
+		if ( system->cart->HasChrRam() ) {
+			system->MapPpuMemory( 0x0000, PPU::PatternTableMemorySize, chrRam, chrRam );
+		} else {
+			system->MapPpuMemory( 0x0000, KB( 4 ), system->cart->GetChrRomBank( chrBank0, KB( 4 ) ), nullptr );
+			system->MapPpuMemory( 0x1000, KB( 4 ), system->cart->GetChrRomBank( chrBank1, KB( 4 ) ), nullptr );
+		}
+	}
+
+	void MapPrgBanks()
+	{
+		system->MapCpuMemory( wtSystem::Bank0, wtSystem::BankSize, system->cart->GetPrgRomBank( bank0 | bank256 ), nullptr );
+		system->MapCpuMemory( wtSystem::Bank1, wtSystem::BankSize, system->cart->GetPrgRomBank( bank1 | bank256 ), nullptr );
+	}
+
 	uint8_t MapMemory( const uint16_t address, const uint8_t regValue )
 	{
 		uint16_t mode = ( address >> 13 ) & 3; // Only bits 13-14 decoded
@@ -98,6 +114,7 @@ private:
 				bank256 = ( regValue & 0x10 );
 				ramDisable = ( regValue & 0x10 ) != 0;
 			}
+			MapChrBanks();
 		}
 		else if ( mode == 2 ) // CHR bank 1
 		{
@@ -107,6 +124,7 @@ private:
 				chrBank1 = chrBank1Reg;
 				bank256 = ( regValue & 0x10 );
 				ramDisable = ( regValue & 0x10 ) != 0;
+				MapChrBanks();
 			}
 		}
 		else if ( mode == 3 ) // PRG bank
@@ -136,6 +154,7 @@ private:
 			}
 		}
 
+		MapPrgBanks();
 		return 0;
 	}
 
@@ -163,12 +182,15 @@ public:
 		bank1 = 0x0F;
 		chrBank0 = 0;
 		chrBank1 = 1;
+		MapPrgBanks();
+		system->MapCpuMemory( wtSystem::SramBase, wtSystem::SramSize, prgRamBank, prgRamBank );
 		return 0;
 	}
 
 	uint8_t OnLoadPpu() override
 	{
 		memset( chrRam, 0, sizeof( PPU::PatternTableMemorySize ) );
+		MapChrBanks();
 		return 0;
 	}
 
@@ -194,30 +216,6 @@ public:
 		return 0;
 	}
 
-	uint8_t	ReadChrRom( const uint16_t addr ) const override
-	{
-		if ( InRange( addr, 0x0000, 0x1FFF ) && system->cart->HasChrRam() ) {
-			return chrRam[ addr ];
-		}
-		else if ( InRange( addr, 0x0000, 0x0FFF ) ) {
-			return system->cart->GetChrRomBank( chrBank0, KB( 4 ) )[ addr ];
-		}
-		else if ( InRange( addr, 0x1000, 0x1FFF ) ) {
-			return system->cart->GetChrRomBank( chrBank1, KB( 4 ) )[ addr - 0x1000 ];
-		}
-		assert( 0 );
-		return 0;
-	}
-
-	uint8_t	WriteChrRam( const uint16_t addr, const uint8_t value ) override
-	{
-		if ( InRange( addr, 0x0000, 0x1FFF ) && system->cart->HasChrRam() ) {
-			chrRam[ addr ] = value;
-			return 1;
-		}
-		return 0;
-	}
-
 	bool InWriteWindow( const uint16_t addr, const uint16_t offset ) const override
 	{
 		const uint16_t address = ( addr + offset );
@@ -277,5 +275,10 @@ public:
 
 		serializer.NextArray( reinterpret_cast<uint8_t*>( &prgRamBank[ 0 ] ), KB( 8 ) );
 		serializer.NextArray( reinterpret_cast<uint8_t*>( &chrRam[ 0 ] ), PPU::PatternTableMemorySize );
+
+		if ( serializer.GetMode() == serializeMode_t::LOAD ) {
+			MapPrgBanks();
+			MapChrBanks();
+		}
 	}
 };
\ No newline at end of file
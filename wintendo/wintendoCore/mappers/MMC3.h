@@ -52,6 +52,14 @@ private:
 		return 0;
 	}
 
+	void MapPrgBanks()
+	{
+		system->MapCpuMemory( 0x8000, KB(8), system->cart->GetPrgRomBank( bank0, KB(8) ), nullptr );
+		system->MapCpuMemory( 0xA000, KB(8), system->cart->GetPrgRomBank( bank1, KB(8) ), nullptr );
+		system->MapCpuMemory( 0xC000, KB(8), system->cart->GetPrgRomBank( bank2, KB(8) ), nullptr );
+		system->MapCpuMemory( 0xE000, KB(8), system->cart->GetPrgRomBank( bank3, KB(8) ), nullptr );
+	}
+
 	void SetPrgBanks()
 	{
 		if ( bankSelect.sem.prgRomBankMode )
@@ -68,6 +76,7 @@ private:
 			bank2 = 0x3E;
 			bank3 = 0x3F;
 		}
+		MapPrgBanks();
 	}
 
 	void SetChrBanks()
@@ -94,6 +103,21 @@ private:
 			chrBank6 = R[ 4 ];
 			chrBank7 = R[ 5 ];
 		}
+
+		MapChrBanks();
+	}
+
+	void MapChrBanks()
+	{
+		if ( system->cart->HasChrRam() ) {
+			system->MapPpuMemory( 0x0000, PPU::PatternTableMemorySize, chrRam, chrRam );
+			return;
+		}
+
+		const uint8_t banks[ 8 ] = { chrBank0, chrBank1, chrBank2, chrBank3, chrBank4, chrBank5, chrBank6, chrBank7 };
+		for ( uint32_t bankIx = 0; bankIx < 8; ++bankIx ) {
+			system->MapPpuMemory( bankIx * KB_1, KB_1, system->cart->GetChrRomBank( banks[ bankIx ], KB_1 ), nullptr );
+		}
 	}
 
 public:
@@ -121,6 +145,8 @@ public:
 		bank1 = 0x01;
 		bank2 = 0x3E;
 		bank3 = 0x3F; // always fixed
+		MapPrgBanks();
+		system->MapCpuMemory( wtSystem::SramBase, wtSystem::SramSize, prgRamBank, prgRamBank );
 
 		return 0;
 	}
@@ -128,6 +154,7 @@ public:
 	uint8_t OnLoadPpu() override
 	{
 		memset( chrRam, 0, sizeof( PPU::PatternTableMemorySize ) );
+		SetChrBanks();
 		return 0;
 	}
 
@@ -150,6 +177,11 @@ public:
 		}
 	}
 
+	bool IrqEnabled() const override
+	{
+		return irqEnable;
+	}
+
 	uint8_t	ReadRom( const uint16_t addr ) const override
 	{	
 		//uint8_t bank = 0;
@@ -196,48 +228,6 @@ public:
 		return 0;
 	}
 
-	uint8_t	ReadChrRom( const uint16_t addr ) const override
-	{
-		if ( system->cart->HasChrRam() && InRange( addr, 0x0000, 0x1FFF ) ) {
-			return chrRam[ addr ];
-		}
-		else if ( InRange( addr, 0x0000, 0x03FF ) ) {
-			return system->cart->GetChrRomBank( chrBank0, KB_1 )[ addr - 0x0000 ];
-		}
-		else if ( InRange( addr, 0x0400, 0x07FF ) ) {
-			return system->cart->GetChrRomBank( chrBank1, KB_1 )[ addr - 0x0400 ];
-		}
-		else if ( InRange( addr, 0x0800, 0x0BFF ) ) {
-			return system->cart->GetChrRomBank( chrBank2, KB_1 )[ addr - 0x0800 ];
-		}
-		else if ( InRange( addr, 0x0C00, 0x0FFF ) ) {
-			return system->cart->GetChrRomBank( chrBank3, KB_1 )[ addr - 0x0C00 ];
-		}
-		else if ( InRange( addr, 0x1000, 0x13FF ) ) {
-			return system->cart->GetChrRomBank( chrBank4, KB_1 )[ addr - 0x1000 ];
-		}
-		else if ( InRange( addr, 0x1400, 0x17FF ) ) {
-			return system->cart->GetChrRomBank( chrBank5, KB_1 )[ addr - 0x1400 ];
-		}
-		else if ( InRange( addr, 0x1800, 0x1BFF ) ) {
-			return system->cart->GetChrRomBank( chrBank6, KB_1 )[ addr - 0x1800 ];
-		}
-		else if ( InRange( addr, 0x1C00, 0x1FFF ) ) {
-			return system->cart->GetChrRomBank( chrBank7, KB_1 )[ addr - 0x1C00 ];
-		}
-		assert( 0 );
-		return 0;
-	}
-
-	uint8_t	 WriteChrRam( const uint16_t addr, const uint8_t value ) override
-	{
-		if ( InRange( addr, 0x0000, 0x1FFF ) && system->cart->HasChrRam() ) {
-			chrRam[ addr ] = value;
-			return 1;
-		}
-		return 0;
-	}
-
 	uint8_t Write( const uint16_t address, const uint8_t value ) override
 	{
 		if ( InRange( address, wtSystem::SramBase, wtSystem::SramEnd ) ) {
@@ -325,5 +315,10 @@ public:
 		serializer.NextArray( reinterpret_cast<uint8_t*>( &R[ 0 ] ), 8 * sizeof( R[ 0 ] ) );
 		serializer.NextArray( reinterpret_cast<uint8_t*>( &prgRamBank[ 0 ] ), KB(8) );
 		serializer.NextArray( reinterpret_cast<uint8_t*>( &chrRam[ 0 ] ), PPU::PatternTableMemorySize );
+
+		if ( serializer.GetMode() == serializeMode_t::LOAD ) {
+			MapPrgBanks();
+			MapChrBanks();
+		}
 	}
 };
\ No newline at end of file
@@ -8,6 +8,7 @@ class NROM : public wtMapper
 private:
 	uint8_t*	prgBanks[2];
 	uint8_t*	chrBank;
+	uint8_t		chrRam[ PPU::PatternTableMemorySize ]; // Carts without CHR-ROM have 8KB of CHR-RAM
 public:
 	NROM( const uint32_t _mapperId )
 	{
@@ -22,15 +23,29 @@ public:
 		const uint8_t bank1 = ( system->cart->GetPrgBankCount() == 1 ) ? 0 : 1;
 		prgBanks[ 0 ] = system->cart->GetPrgRomBank( 0 );
 		prgBanks[ 1 ] = system->cart->GetPrgRomBank( bank1 );
+		system->MapCpuMemory( wtSystem::Bank0, wtSystem::BankSize, prgBanks[ 0 ], nullptr );
+		system->MapCpuMemory( wtSystem::Bank1, wtSystem::BankSize, prgBanks[ 1 ], nullptr );
 		return 0;
 	};
 
 	uint8_t OnLoadPpu() override
 	{
-		chrBank = system->cart->GetChrRomBank( 0 );
+		if ( system->cart->HasChrRam() ) {
+			memset( chrRam, 0, PPU::PatternTableMemorySize );
+			chrBank = chrRam;
+		} else {
+			chrBank = system->cart->GetChrRomBank( 0 );
+		}
+		MapChrBanks();
 		return 0;
 	};
 
+	void MapChrBanks()
+	{
+		uint8_t* writeBank = system->cart->HasChrRam() ? chrRam : nullptr;
+		system->MapPpuMemory( 0x0000, PPU::PatternTableMemorySize, chrBank, writeBank );
+	}
+
 	uint8_t	ReadRom( const uint16_t addr ) const override
 	{
 		const uint8_t bank = ( addr >> 14 ) & 0x01;
@@ -39,8 +54,15 @@ public:
 		return prgBanks[ bank ][ offset ];
 	}
 
-	uint8_t	ReadChrRom( const uint16_t addr ) const override
+	void Serialize( Serializer& serializer ) override
 	{
-		return chrBank[ addr ];
+		if ( !system->cart->HasChrRam() ) {
+			return;
+		}
+
+		serializer.NextArray( chrRam, PPU::PatternTableMemorySize );
+		if ( serializer.GetMode() == serializeMode_t::LOAD ) {
+			MapChrBanks();
+		}
 	}
 };
\ No newline at end of file
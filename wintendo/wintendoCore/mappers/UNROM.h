@@ -26,6 +26,8 @@ public:
 		const uint8_t lastBank = ( system->cart->h.prgRomBanks - 1 );
 		prgBanks[ 0 ] = system->cart->GetPrgRomBank( bank );
 		prgBanks[ 1 ] = system->cart->GetPrgRomBank( lastBank );
+		system->MapCpuMemory( wtSystem::Bank0, wtSystem::BankSize, prgBanks[ 0 ], nullptr );
+		system->MapCpuMemory( wtSystem::Bank1, wtSystem::BankSize, prgBanks[ 1 ], nullptr );
 		return 0;
 	};
 
@@ -37,9 +39,16 @@ public:
 			chrBank = system->cart->GetChrRomBank( 0 );
 		}
 		memset( chrRam, 0, sizeof( PPU::PatternTableMemorySize ) );
+		MapChrBanks();
 		return 0;
 	};
 
+	void MapChrBanks()
+	{
+		uint8_t* writeBank = system->cart->HasChrRam() ? chrRam : nullptr;
+		system->MapPpuMemory( 0x0000, PPU::PatternTableMemorySize, chrBank, writeBank );
+	}
+
 	uint8_t	ReadRom( const uint16_t addr ) const override
 	{
 		const uint8_t bank = ( addr >> 14 ) & 0x01;
@@ -48,24 +57,11 @@ public:
 		return prgBanks[ bank ][ offset ];
 	}
 
-	uint8_t	ReadChrRom( const uint16_t addr ) const override
-	{
-		return chrBank[ addr ];
-	}
-
-	uint8_t	 WriteChrRam( const uint16_t addr, const uint8_t value ) override
-	{
-		if ( InRange( addr, 0x0000, 0x1FFF ) && system->cart->HasChrRam() ) {
-			chrRam[ addr ] = value;
-			return 1;
-		}
-		return 0;
-	}
-
 	uint8_t Write( const uint16_t addr, const uint8_t value ) override
 	{
 		bank = ( value & 0x07 );
 		prgBanks[ 0 ] = system->cart->GetPrgRomBank( bank );
+		system->MapCpuMemory( wtSystem::Bank0, wtSystem::BankSize, prgBanks[ 0 ], nullptr );
 		return 0;
 	};
 
@@ -86,9 +82,11 @@ public:
 		if( serializer.GetMode() == serializeMode_t::LOAD )
 		{
 			prgBanks[ 0 ] = system->cart->GetPrgRomBank( bank );
+			system->MapCpuMemory( wtSystem::Bank0, wtSystem::BankSize, prgBanks[ 0 ], nullptr );
 			if ( !system->cart->HasChrRam() ) {
 				chrBank = system->cart->GetChrRomBank( 0 );
 			}
+			MapChrBanks();
 		}
 	}
 };
\ No newline at end of file
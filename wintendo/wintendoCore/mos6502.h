@@ -50,6 +50,7 @@ typedef void( Cpu6502::* OpCodeFn )( opState_t& opState );
 struct opInfo_t
 {
 	OpCodeFn	func;
+	OpCodeFn	traceFunc;
 	const char*	mnemonic;
 	opType_t	type		: 7;
 	addrMode_t	addrMode	: 5;
@@ -66,15 +67,18 @@ struct opInfo_t
 #define OP_DEF( name )									template <class AddrModeT>												\
 														void name( opState_t& o )
 
-#define ADDR_MODE_DECL( name )							struct addrMode##name													\
+#define ADDR_MODE_DECL( name )							template <bool Traced>													\
+														struct addrMode##name													\
 														{																		\
 															static const addrMode_t addrMode = addrMode_t::##name;				\
+															static const bool traced = Traced;									\
 															Cpu6502& cpu;														\
 															addrMode##name( Cpu6502& _cpu ) : cpu( _cpu ) {};					\
 															inline void operator()( struct opState_t& opState );				\
 														};
 
-#define ADDR_MODE_DEF( name )							FORCE_INLINE void Cpu6502::addrMode##name::operator() ( struct opState_t& opState )
+#define ADDR_MODE_DEF( name )							template <bool Traced>													\
+														FORCE_INLINE void Cpu6502::addrMode##name<Traced>::operator() ( struct opState_t& opState )
 
 #define _OP_ADDR( num, name, addrFunc, addrressMode, ops, advance, cycles, hasExtraCycle, isIllegal )							\
 														{																		\
@@ -84,7 +88,8 @@ struct opInfo_t
 															opLUT[num].operands		= ops;										\
 															opLUT[num].baseCycles	= cycles;									\
 															opLUT[num].pcInc		= advance;									\
-															opLUT[num].func			= &Cpu6502::##name<addrMode##addrFunc>;		\
+															opLUT[num].func			= &Cpu6502::##name<addrMode##addrFunc<false>>;	\
+															opLUT[num].traceFunc	= &Cpu6502::##name<addrMode##addrFunc<true>>;	\
 															opLUT[num].illegal		= isIllegal;								\
 															opLUT[num].extraCycle	= hasExtraCycle;							\
 														}
@@ -154,6 +159,25 @@ struct opState_t
 };
 
 
+enum class opFusion_t : uint8_t
+{
+	NONE,
+	BRANCH,		// DEX/DEY/INX/INY/INC zp/CMP or BIT $2002 followed by a conditional branch
+	STORE,		// LDA followed by STA to internal RAM
+	COUNT_LOOP,	// DEX/DEY/INX/INY/INC zp with a BNE back to itself
+};
+
+
+struct decodedOp_t
+{
+	uint32_t		generation;
+	uint8_t			opCode;
+	uint8_t			op0;
+	uint8_t			op1;
+	opFusion_t		fusion;
+};
+
+
 struct cpuDebug_t
 {
 	uint8_t			X;
@@ -175,6 +199,9 @@ class Cpu6502
 public:
 	static const uint32_t InvalidAddress	= ~0x00;
 	static const uint32_t NumInstructions	= 256;
+	static const uint32_t DecodeCacheBase	= 0x8000; // PRG-ROM window
+	static const uint32_t DecodeCacheSize	= 0x8000;
+	static const uint32_t DecodeCachePages	= ( DecodeCacheSize / 0x100 );
 
 	uint16_t			nmiVector;
 	uint16_t			irqVector;
@@ -182,6 +209,7 @@ public:
 
 	wtSystem*			system;
 	cpuCycle_t			cycle;
+	uint64_t			skippedCycles;
 
 #if DEBUG_ADDR == 1
 	bool				logToFile = false;
@@ -190,6 +218,7 @@ public:
 #endif
 	bool				resetLog;
 	wtLog				dbgLog;
+	wtProfiler			profiler;
 
 	// TODO: move to system
 	mutable uint16_t	irqAddr;
@@ -202,13 +231,22 @@ public:
 	uint8_t				Y;
 	uint8_t				A;
 	uint8_t				SP;
-	statusReg_t			P;
 	uint16_t			PC;
 
 	opInfo_t			opLUT[NumInstructions];
 
 private:
+	// N and Z are evaluated from the last result when P is read, C and V are kept out of the bitfield.
+	// GetStatus() and SetStatus() convert to and from the packed register.
+	statusReg_t			P;
+	uint16_t			zeroResult;
+	uint8_t				signResult;
+	bool				carryFlag;
+	bool				overflowFlag;
+
 	bool				halt;
+	decodedOp_t			decodeCache[ DecodeCacheSize ];
+	uint32_t			decodePageGen[ DecodeCachePages ];
 
 public:
 	void Reset()
@@ -223,8 +261,10 @@ public:
 		P.byte = 0;
 		P.bit.i = 1;
 		P.bit.b = 1;
+		SetStatus( P.byte );
 
 		cycle = cpuCycle_t( 7 ); // FIXME: +7 is a hack to match test log, +21 on PPU
+		skippedCycles = 0;
 
 		interruptRequestNMI = false;
 		interruptRequest = false;
@@ -235,11 +275,18 @@ public:
 
 		resetLog = false;
 		dbgLog.Reset( 1 );
+
+		// Entries only match their page's current generation, so bumping every page drops the cache without touching it
+		for ( uint32_t i = 0; i < DecodeCachePages; ++i ) {
+			++decodePageGen[ i ];
+		}
 	}
 
 	Cpu6502()
 	{
 		resetLog = false;
+		memset( decodeCache, 0, sizeof( decodeCache ) );
+		memset( decodePageGen, 0, sizeof( decodePageGen ) );
 		Reset();
 		BuildOpLUT();
 	}
@@ -249,6 +296,9 @@ public:
 	bool IsTraceLogOpen() const;
 	void StartTraceLog( const uint32_t frameCount );
 	void StopTraceLog();
+	void InvalidateDecodedOps( const uint16_t address, const uint32_t size );
+	statusReg_t GetStatus() const;
+	void SetStatus( const uint8_t status );
 
 	void Serialize( Serializer& serializer );
 
@@ -271,7 +321,13 @@ private:
 	ADDR_MODE_DECL( JmpIndirect )
 	uint16_t	JumpImmediateAddr( const uint16_t addr );
 
-	cpuCycle_t	Exec();
+	template <bool Traced>
+	bool		StepOps( const cpuCycle_t& nextCycle );
+
+	template <bool Traced>
+	cpuCycle_t	Exec( const cpuCycle_t& nextCycle );
+
+	void		SkipIdleLoop( const uint16_t jumpAddr, const cpuCycle_t& jumpCycles, const cpuCycle_t& nextCycle );
 
 	static bool	CheckSign( const uint16_t checkValue );
 	static bool	CheckCarry( const uint16_t checkValue );
@@ -281,7 +337,10 @@ private:
 	void		NMI( const uint16_t addr );
 	void		IRQ();
 
+	template <bool Traced>
 	void		IndexedAbsolute( opState_t& opState, const uint8_t& reg );
+
+	template <bool Traced>
 	void		IndexedZero( opState_t& opState, const uint8_t& reg );
 
 	void		Push( const uint8_t value );
@@ -298,6 +357,8 @@ private:
 	uint16_t	CombineIndirect( const uint8_t lsb, const uint8_t msb, const uint32_t wrap );
 
 	uint8_t		AddressCrossesPage( opState_t& opState, const uint16_t address, const uint16_t offset );
+
+	template <bool Traced>
 	void		Branch( opState_t& opState, const bool takeBranch );
 	
 	template <class AddrFunctor>
@@ -306,5 +367,10 @@ private:
 	template <class AddrFunctor>
 	void		Write( opState_t& opState, const uint8_t value );
 
-	cpuCycle_t	OpExec( const uint16_t instrAddr, const uint8_t opCode );
+	const decodedOp_t*	FindDecodedOp( const uint16_t instrAddr );
+	opFusion_t			FindFusion( const uint16_t instrAddr, const uint8_t opCode, const uint8_t op0, const uint8_t op1 );
+	cpuCycle_t			FusedExec( const uint16_t instrAddr, const decodedOp_t& decodedOp, const cpuCycle_t& nextCycle );
+
+	template <bool Traced>
+	cpuCycle_t	OpExec( const uint16_t instrAddr, const uint8_t opCode, const decodedOp_t* decodedOp );
 };
\ No newline at end of file
@@ -7,12 +7,15 @@
 #include <atomic>
 #include <wchar.h>
 #include <memory>
+#include <vector>
+#include <algorithm>
 #include "common.h"
 #include "NesSystem.h"
 #include "mos6502.h"
 #include "input.h"
 #include "mapper.h"
 #include "timer.h"
+#include "ppu_composite.h"
 
 
 static void LoadNesFile( const std::wstring& fileName, unique_ptr<wtCart>& outCart )
@@ -94,11 +97,13 @@ void wtSystem::Shutdown()
 void wtSystem::LoadProgram( const uint32_t resetVectorManual )
 {
 	memset( memory, 0, PhysicalMemorySize );
+	ResetMemoryMap();
 
 	cart->mapper = AssignMapper( cart->GetMapperId() );
 	cart->mapper->system = this;
 	cart->mapper->OnLoadCpu();
 	cart->mapper->OnLoadPpu();
+	ppu.InvalidateChrCache( 0x0000, PPU::PatternTableMemorySize );
 
 	if ( resetVectorManual == 0x10000 ) {
 		cpu.resetVector = Combine( ReadMemory( ResetVectorAddr ), ReadMemory( ResetVectorAddr + 1 ) );
@@ -112,11 +117,11 @@ void wtSystem::LoadProgram( const uint32_t resetVectorManual )
 	cpu.PC = cpu.resetVector;
 
 	if ( cart->h.controlBits0.fourScreenMirror ) {
-		mirrorMode = MIRROR_MODE_FOURSCREEN;
+		SetMirrorMode( MIRROR_MODE_FOURSCREEN );
 	} else if ( cart->h.controlBits0.mirror ) {
-		mirrorMode = MIRROR_MODE_VERTICAL;
+		SetMirrorMode( MIRROR_MODE_VERTICAL );
 	} else {
-		mirrorMode = MIRROR_MODE_HORIZONTAL;
+		SetMirrorMode( MIRROR_MODE_HORIZONTAL );
 	}
 }
 
@@ -201,36 +206,141 @@ uint8_t wtSystem::GetMirrorMode() const
 void wtSystem::SetMirrorMode( uint8_t mode )
 {
 	mirrorMode = mode;
+	ppu.MapNameTables( mode );
 }
 
 
-bool wtSystem::MouseInRegion( const wtRect& region ) // TODO: draft code, kill later
+void wtSystem::MapPpuMemory( const uint16_t address, const uint32_t size, uint8_t* readPtr, uint8_t* writePtr )
 {
-	return ( ( input.mousePoint.x >= region.x ) && ( input.mousePoint.x < region.width ) && ( input.mousePoint.y >= region.y ) && ( input.mousePoint.y < region.height ) );
+	ppu.MapChrMemory( address, size, readPtr, writePtr );
+}
+
+
+void wtSystem::ResetMemoryMap()
+{
+	for ( uint32_t page = 0; page < PageCount; ++page )
+	{
+		const uint16_t address = static_cast<uint16_t>( page * PageSize );
+		if ( IsPhysicalMemory( address ) )
+		{
+			readPages[ page ]		= &memory[ address % PhysicalMemorySize ];
+			writePages[ page ]		= &memory[ address % PhysicalMemorySize ];
+			readHandlers[ page ]	= nullptr;
+			writeHandlers[ page ]	= nullptr;
+		}
+		else if ( IsPpuRegister( address ) )
+		{
+			readPages[ page ]		= nullptr;
+			writePages[ page ]		= nullptr;
+			readHandlers[ page ]	= &wtSystem::ReadPpuRegister;
+			writeHandlers[ page ]	= &wtSystem::WritePpuRegister;
+		}
+		else if ( address == ApuRegisterBase )
+		{
+			readPages[ page ]		= nullptr;
+			writePages[ page ]		= nullptr;
+			readHandlers[ page ]	= &wtSystem::ReadIoRegister;
+			writeHandlers[ page ]	= &wtSystem::WriteIoRegister;
+		}
+		else
+		{
+			readPages[ page ]		= nullptr;
+			writePages[ page ]		= nullptr;
+			readHandlers[ page ]	= &wtSystem::ReadCartMemory;
+			writeHandlers[ page ]	= &wtSystem::WriteCartMemory;
+		}
+	}
+	cpu.InvalidateDecodedOps( 0, VirtualMemorySize );
+}
+
+
+void wtSystem::MapCpuMemory( const uint16_t address, const uint32_t size, uint8_t* readPtr, uint8_t* writePtr )
+{
+	assert( ( address % PageSize ) == 0 );
+	assert( ( size % PageSize ) == 0 );
+
+	const uint32_t firstPage = ( address / PageSize );
+	const uint32_t lastPage = firstPage + ( size / PageSize );
+	assert( lastPage <= PageCount );
+
+	bool remapped = false;
+	for ( uint32_t page = firstPage; page < lastPage; ++page )
+	{
+		const uint32_t pageOffset = ( page - firstPage ) * PageSize;
+		uint8_t* pageReadPtr = ( readPtr != nullptr ) ? ( readPtr + pageOffset ) : nullptr;
+		uint8_t* pageWritePtr = ( writePtr != nullptr ) ? ( writePtr + pageOffset ) : nullptr;
+
+		remapped = remapped || ( readPages[ page ] != pageReadPtr ) || ( writePages[ page ] != pageWritePtr );
+		readPages[ page ] = pageReadPtr;
+		writePages[ page ] = pageWritePtr;
+	}
+
+	if ( remapped ) {
+		cpu.InvalidateDecodedOps( address, size );
+	}
+}
+
+
+bool wtSystem::IsRomMemory( const uint16_t address ) const
+{
+	const uint32_t page = ( address / PageSize );
+	return ( readPages[ page ] != nullptr ) && ( writePages[ page ] == nullptr );
+}
+
+
+int32_t wtSystem::GetPrgRomOffset( const uint16_t address ) const
+{
+	const uint8_t* pagePtr = readPages[ address / PageSize ];
+	if ( ( pagePtr == nullptr ) || ( cart == nullptr ) ) {
+		return -1;
+	}
+
+	const uint8_t* prgRom = cart->GetPrgRomBank( 0 );
+	const ptrdiff_t prgOffset = ( pagePtr + ( address % PageSize ) ) - prgRom;
+	const ptrdiff_t prgSize = KB( 16 ) * (ptrdiff_t)cart->h.prgRomBanks;
+
+	return ( ( prgOffset >= 0 ) && ( prgOffset < prgSize ) ) ? static_cast<int32_t>( prgOffset ) : -1;
 }
 
 
 uint8_t wtSystem::ReadMemory( const uint16_t address )
+{
+	const uint32_t page = ( address / PageSize );
+	const uint8_t* pagePtr = readPages[ page ];
+	if ( pagePtr != nullptr )
+	{
+		return pagePtr[ address % PageSize ];
+	}
+	return ( this->*readHandlers[ page ] )( address );
+}
+
+
+uint8_t wtSystem::ReadPpuRegister( const uint16_t address )
+{
+	CatchUp( cpu.cycle, SYNC_EVENT_PPU_REG );
+	return ppu.ReadReg( MirrorAddress( address ) );
+}
+
+
+uint8_t wtSystem::ReadIoRegister( const uint16_t address )
 {
 	const uint16_t mAddr = MirrorAddress( address );
 	if ( IsCartMemory( mAddr ) )
 	{
 		return cart->mapper->ReadRom( mAddr );
 	}
-	else if ( IsPpuRegister( mAddr ) )
-	{
-		return ppu.ReadReg( mAddr );
-	}
 	else if ( mAddr == 0x4017 )
 	{
 		// FIXME: what to return?
 		// https://wiki.nesdev.com/w/index.php/APU_DMC#cite_note-2
 		// This note describes the register conflict	
+		CatchUp( cpu.cycle, SYNC_EVENT_APU_REG );
 		ReadInput( mAddr );
 		return apu.ReadReg( mAddr );
 	}
 	else if ( IsApuRegister( mAddr ) )
 	{
+		CatchUp( cpu.cycle, SYNC_EVENT_APU_REG );
 		return apu.ReadReg( mAddr );
 	}
 	else if ( IsInputRegister( mAddr ) )
@@ -245,6 +355,12 @@ uint8_t wtSystem::ReadMemory( const uint16_t address )
 }
 
 
+uint8_t wtSystem::ReadCartMemory( const uint16_t address )
+{
+	return cart->mapper->ReadRom( address );
+}
+
+
 uint8_t wtSystem::ReadZeroPage( const uint16_t address )
 {
 	assert( address <= ZeroPageEnd );
@@ -254,21 +370,42 @@ uint8_t wtSystem::ReadZeroPage( const uint16_t address )
 
 void wtSystem::WriteMemory( const uint16_t address, const uint16_t offset, const uint8_t value )
 {
-	const uint32_t fullAddr = address + offset;
-	const uint16_t mAddr = MirrorAddress( fullAddr );
-	if ( IsPpuRegister( mAddr ) )
+	const uint16_t fullAddr = static_cast<uint16_t>( address + offset );
+	const uint32_t page = ( fullAddr / PageSize );
+	uint8_t* pagePtr = writePages[ page ];
+	if ( pagePtr != nullptr )
 	{
-		ppu.WriteReg( mAddr, value );
+		pagePtr[ fullAddr % PageSize ] = value;
+		return;
 	}
-	else if ( wtSystem::IsDMA( mAddr ) )
+	( this->*writeHandlers[ page ] )( fullAddr, offset, value );
+}
+
+
+void wtSystem::WritePpuRegister( const uint16_t address, const uint16_t offset, const uint8_t value )
+{
+	CatchUp( cpu.cycle, SYNC_EVENT_PPU_REG );
+	ppu.WriteReg( MirrorAddress( address ), value );
+	ScheduleSync();
+}
+
+
+void wtSystem::WriteIoRegister( const uint16_t address, const uint16_t offset, const uint8_t value )
+{
+	const uint16_t mAddr = MirrorAddress( address );
+	if ( wtSystem::IsDMA( mAddr ) )
 	{
+		CatchUp( cpu.cycle, SYNC_EVENT_PPU_REG );
 		ppu.IssueDMA( value );
 		apu.WriteReg( mAddr, value );
+		ScheduleSync();
 	}
 	else if ( mAddr == 0x4017 )
 	{
+		CatchUp( cpu.cycle, SYNC_EVENT_APU_REG );
 		WriteInput( mAddr, value );
 		apu.WriteReg( mAddr, value );
+		ScheduleSync();
 	}
 	else if ( IsInputRegister( mAddr ) )
 	{
@@ -276,15 +413,36 @@ void wtSystem::WriteMemory( const uint16_t address, const uint16_t offset, const
 	}
 	else if ( wtSystem::IsApuRegister( mAddr ) )
 	{
+		CatchUp( cpu.cycle, SYNC_EVENT_APU_REG );
 		apu.WriteReg( mAddr, value );
+		ScheduleSync();
 	}
-	else if ( cart->mapper->InWriteWindow( mAddr, offset ) )
+	else
+	{
+		WriteCartMemory( mAddr, offset, value );
+	}
+}
+
+
+void wtSystem::WriteCartMemory( const uint16_t address, const uint16_t offset, const uint8_t value )
+{
+	if ( cart->mapper->InWriteWindow( address, offset ) )
 	{
-		cart->mapper->Write( mAddr, value );
+		// Bank and IRQ registers change what the PPU fetches and when the mapper fires
+		const bool isMapperReg = ( address >= Bank0 );
+		if ( isMapperReg ) {
+			CatchUp( cpu.cycle, SYNC_EVENT_MAPPER_REG );
+		}
+
+		cart->mapper->Write( address, value );
+
+		if ( isMapperReg ) {
+			ScheduleSync();
+		}
 	}
 	else
 	{
-		WritePhysicalMemory( mAddr, value );
+		WritePhysicalMemory( address, value );
 	}
 }
 
@@ -333,12 +491,15 @@ void wtSystem::WriteInput( const uint16_t address, const uint8_t value )
 
 void wtSystem::GetFrameResult( wtFrameResult& outFrameResult )
 {
-	outFrameResult.frameBuffer		= &frameBuffer[ finishedFrameIx ];
+	const bool indexedOutput		= config->ppu.indexedFrameBuffer;
+	outFrameResult.frameBuffer		= indexedOutput ? nullptr : &frameBuffer[ finishedFrameIx ];
+	outFrameResult.indexedFrameBuffer = indexedOutput ? &indexedFrameBuffer[ finishedFrameIx ] : nullptr;
 	outFrameResult.nameTableSheet	= &nameTableSheet;
 	outFrameResult.paletteDebug		= &paletteDebug;
 	outFrameResult.patternTable0	= &patternTable0;
 	outFrameResult.patternTable1	= &patternTable1;
 	outFrameResult.pickedObj8x16	= &pickedObj8x16;
+	outFrameResult.vramHeatmap		= &vramHeatmapImage;
 	outFrameResult.ppuDebug			= ppu.dbgInfo;
 
 	GetState( outFrameResult.cpuDebug );
@@ -348,6 +509,8 @@ void wtSystem::GetFrameResult( wtFrameResult& outFrameResult )
 		outFrameResult.dbgLog		= &cpu.dbgLog;
 	}
 #endif
+	UpdateProfileSnapshot();
+	outFrameResult.profile			= profileSnapshot;
 	outFrameResult.dbgInfo			= dbgInfo;
 	outFrameResult.romHeader		= cart->h;
 	outFrameResult.mirrorMode		= static_cast<wtMirrorMode>( GetMirrorMode() );
@@ -369,12 +532,34 @@ void wtSystem::GetFrameResult( wtFrameResult& outFrameResult )
 }
 
 
+void wtSystem::ExpandFrameBuffer( const wtIndexedDisplayImage& src, wtDisplayImage& dest, const BitmapFormat format ) const
+{
+	// One table per emphasis setting, each line is expanded with the bits the PPU stored for it
+	static const uint32_t EmphasisCount = 8;
+	uint32_t colors[ EmphasisCount ][ 64 ];
+	for ( uint8_t emphasis = 0; emphasis < EmphasisCount; ++emphasis )
+	{
+		for ( uint32_t colorIx = 0; colorIx < 64; ++colorIx )
+		{
+			Pixel pixel;
+			Bitmap::CopyToPixel( PPU::EmphasizeColor( ppu.palette[ colorIx ], emphasis ), pixel, format );
+			colors[ emphasis ][ colorIx ] = pixel.rawABGR;
+		}
+	}
+
+	const uint32_t width = src.GetWidth();
+	for ( uint32_t y = 0; y < src.GetHeight(); ++y ) {
+		ExpandIndexedPixels( dest.GetRawBuffer() + y * width, src.GetRawBuffer() + y * width, width, colors[ src.GetEmphasis( y ) % EmphasisCount ] );
+	}
+}
+
+
 void wtSystem::GetState( cpuDebug_t& state )
 {
 	state.A = cpu.A;
 	state.X = cpu.X;
 	state.Y = cpu.Y;
-	state.P = cpu.P;
+	state.P = cpu.GetStatus();
 	state.PC = cpu.PC;
 	state.SP = cpu.SP;
 	state.resetVector = cpu.resetVector;
@@ -395,6 +580,12 @@ const APU& wtSystem::GetAPU() const
 }
 
 
+wtAudioRing& wtSystem::GetAudioRing()
+{
+	return apu.GetAudioRing();
+}
+
+
 wtInput* wtSystem::GetInput()
 {
 	return &input;
@@ -419,6 +610,18 @@ wtDisplayImage* wtSystem::GetBackbuffer()
 }
 
 
+wtIndexedDisplayImage* wtSystem::GetIndexedBackbuffer()
+{
+	return &indexedFrameBuffer[ currentFrameIx ];
+}
+
+
+wtSpriteIdImage* wtSystem::GetSpriteIdBuffer()
+{
+	return &spriteIdBuffer;
+}
+
+
 void wtSystem::InitConfig( config_t& config )
 {
 	// System
@@ -428,6 +631,8 @@ void wtSystem::InitConfig( config_t& config )
 	config.ppu.chrPalette		= 0;
 	config.ppu.showBG			= true;
 	config.ppu.showSprite		= true;
+	config.ppu.indexedFrameBuffer = false;
+	config.ppu.spriteIdBuffer	= false;
 	config.ppu.spriteLimit		= PPU::SecondarySprites;
 
 	// APU
@@ -442,6 +647,7 @@ void wtSystem::InitConfig( config_t& config )
 	config.apu.muteNoise		= false;
 	config.apu.muteDMC			= false;
 	config.apu.dbgChannelBits	= 0;
+	config.apu.scopeCyclesPerBucket = 64;
 }
 
 
@@ -578,27 +784,96 @@ void wtSystem::LoadState()
 }
 
 
+masterCycle_t wtSystem::AlignToTick( const masterCycle_t& cycle ) const
+{
+	static const uint64_t ticks = CpuClockDivide;
+
+	if ( !( sysCycles < cycle ) ) {
+		return ( sysCycles + masterCycle_t( ticks ) );
+	}
+
+	const uint64_t tickCount = ( ( cycle - sysCycles ).count() + ticks - 1 ) / ticks;
+	return ( sysCycles + masterCycle_t( tickCount * ticks ) );
+}
+
+
+void wtSystem::ScheduleSync()
+{
+	// The CPU runs ahead until the earliest point where it could observe PPU/APU state.
+	// Event cycles are converted to the first tick where the lockstep loop would have run them.
+	masterCycle_t nextSync = runEndCycle;
+	syncEvent = SYNC_EVENT_EPOCH;
+
+	syncEvent_t ppuEvent;
+	const ppuCycle_t ppuCycle = ppu.NextSyncCycle( ppuEvent );
+	const masterCycle_t ppuSync = masterCycle_t( ( ppuCycle.count() + 1 ) * PpuClockDivide );
+	if ( ppuSync < nextSync )
+	{
+		nextSync = ppuSync;
+		syncEvent = ppuEvent;
+	}
+
+#ifndef _DEBUG
+	syncEvent_t apuEvent;
+	const cpuCycle_t apuCycle = apu.NextSyncCycle( apuEvent );
+	if ( apuEvent != SYNC_EVENT_COUNT )
+	{
+		const masterCycle_t apuSync = masterCycle_t( ( apuCycle.count() + 1 ) * CpuClockDivide );
+		if ( apuSync < nextSync )
+		{
+			nextSync = apuSync;
+			syncEvent = apuEvent;
+		}
+	}
+#endif
+
+	syncCycle = MasterToCpuCycle( AlignToTick( nextSync ) );
+
+#if DEBUG_ADDR == 1
+	if ( cpu.IsTraceLogOpen() )
+	{
+		// Trace lines record the PPU position of every instruction so fall back to lockstep
+		syncCycle = MasterToCpuCycle( AlignToTick( sysCycles ) );
+		syncEvent = SYNC_EVENT_TRACE;
+	}
+#endif // #if DEBUG_ADDR == 1
+}
+
+
+void wtSystem::CatchUp( const cpuCycle_t& targetCycle, const syncEvent_t event )
+{
+	const cpuCycle_t currentCycle = MasterToCpuCycle( sysCycles );
+	if ( !( currentCycle < targetCycle ) ) {
+		return;
+	}
+
+	sysCycles += CpuToMasterCycle( targetCycle - currentCycle );
+
+	ppu.Step( MasterToPpuCycle( sysCycles ) );
+#ifndef _DEBUG
+	apu.Step( MasterToCpuCycle( sysCycles ) );
+#endif
+
+	++dbgInfo.syncCount[ event ];
+}
+
+
 bool wtSystem::Run( const masterCycle_t& nextCycle )
 {
 	bool isRunning = true;
 
-	static const masterCycle_t ticks( CpuClockDivide );
+	runEndCycle = nextCycle;
 
 	apu.Begin();
 
 	// TODO: CHECK WRAP AROUND LOGIC
 	while ( ( sysCycles < nextCycle ) && isRunning )
 	{
-		sysCycles += ticks;
+		ScheduleSync();
 
-		const cpuCycle_t nextCpuCycle = MasterToCpuCycle( sysCycles );
-		const ppuCycle_t nextPpuCycle = MasterToPpuCycle( sysCycles );
-
-		isRunning = cpu.Step( nextCpuCycle );
-		ppu.Step( nextPpuCycle );
-#ifndef _DEBUG
-		apu.Step( nextCpuCycle );
-#endif
+		// syncCycle is passed by reference, register writes can pull it in while the CPU runs
+		isRunning = cpu.Step( syncCycle );
+		CatchUp( syncCycle, syncEvent );
 	}
 	apu.End();
 
@@ -662,6 +937,170 @@ string wtSystem::GetPrgBankDissambly( const uint8_t bankNum )
 }
 
 
+void wtSystem::UpdateProfileSnapshot()
+{
+	const wtProfiler& profiler = cpu.profiler;
+	if ( !profiler.HasSamples() )
+	{
+		profileSnapshot.totalStats = { 0, 0 };
+		profileSnapshot.hotSpotCount = 0;
+		return;
+	}
+
+	// Ranking walks every address, so skip it while the profiler is stopped
+	const profileStat_t& total = profiler.GetTotalStats();
+	if ( ( total.count == profileSnapshot.totalStats.count ) && ( total.cycles == profileSnapshot.totalStats.cycles ) ) {
+		return;
+	}
+
+	profileSnapshot.totalStats = total;
+	for ( uint32_t opCode = 0; opCode < wtProfiler::OpCodeCount; ++opCode ) {
+		profileSnapshot.opStats[ opCode ] = profiler.GetOpStats( opCode );
+	}
+	for ( uint32_t mode = 0; mode < wtProfiler::AddrModeCount; ++mode ) {
+		profileSnapshot.addrModeStats[ mode ] = profiler.GetAddrModeStats( mode );
+	}
+
+	// PRG-ROM is keyed by bank so swapped code isn't merged, anything else by CPU address
+	std::vector<profileHotSpot_t> hotSpots;
+	for ( uint32_t prgOffset = 0; prgOffset < profiler.GetPrgSize(); ++prgOffset )
+	{
+		const profileStat_t& stats = profiler.GetPrgStats( prgOffset );
+		if ( stats.count > 0 ) {
+			hotSpots.push_back( { static_cast<int32_t>( prgOffset / BankSize ), prgOffset % BankSize, stats } );
+		}
+	}
+	for ( uint32_t address = 0; address < Bank0; ++address )
+	{
+		const profileStat_t& stats = profiler.GetAddressStats( address );
+		if ( stats.count > 0 ) {
+			hotSpots.push_back( { -1, address, stats } );
+		}
+	}
+
+	const size_t hotSpotCount = std::min<size_t>( hotSpots.size(), profileSnapshot_t::MaxHotSpots );
+	std::partial_sort( hotSpots.begin(), hotSpots.begin() + hotSpotCount, hotSpots.end(), []( const profileHotSpot_t& lhs, const profileHotSpot_t& rhs ) {
+		return lhs.stats.cycles > rhs.stats.cycles;
+	} );
+	std::copy( hotSpots.begin(), hotSpots.begin() + hotSpotCount, profileSnapshot.hotSpots );
+	profileSnapshot.hotSpotCount = static_cast<uint32_t>( hotSpotCount );
+}
+
+
+string wtSystem::GetProfileReport( const profileSnapshot_t& profile, const uint32_t maxHotSpots )
+{
+	static const char* AddrModeNames[ wtProfiler::AddrModeCount ] =
+	{
+		"None",
+		"Absolute",
+		"Zero",
+		"Immediate",
+		"IndexedIndirect",
+		"IndirectIndexed",
+		"Accumulator",
+		"IndexedAbsoluteX",
+		"IndexedAbsoluteY",
+		"IndexedZeroX",
+		"IndexedZeroY",
+		"Jmp",
+		"JmpIndirect",
+		"Jsr",
+		"Return",
+		"Branch",
+	};
+
+	std::stringstream debugStream;
+	if ( profile.totalStats.count == 0 ) {
+		return debugStream.str();
+	}
+
+	const profileStat_t& total = profile.totalStats;
+	const double cyclePercent = 100.0 / total.cycles;
+	debugStream << "Instructions: " << dec << total.count << "  Cycles: " << total.cycles << std::endl << std::endl;
+
+	std::vector<uint32_t> opCodes;
+	for ( uint32_t opCode = 0; opCode < wtProfiler::OpCodeCount; ++opCode )
+	{
+		if ( profile.opStats[ opCode ].count > 0 ) {
+			opCodes.push_back( opCode );
+		}
+	}
+	std::sort( opCodes.begin(), opCodes.end(), [&]( const uint32_t lhs, const uint32_t rhs ) {
+		return profile.opStats[ lhs ].cycles > profile.opStats[ rhs ].cycles;
+	} );
+
+	debugStream << "Op  Mnemonic  Mode              Count       Cycles      %" << std::endl;
+	for ( const uint32_t opCode : opCodes )
+	{
+		const profileStat_t& stats = profile.opStats[ opCode ];
+		const opInfo_t& op = cpu.opLUT[ opCode ];
+		debugStream << uppercase << right << setfill( '0' ) << setw( 2 ) << hex << opCode << setfill( ' ' ) << dec << "  " << left;
+		debugStream << setw( 10 ) << op.mnemonic << setw( 18 ) << AddrModeNames[ static_cast<uint32_t>( op.addrMode ) ];
+		debugStream << setw( 12 ) << stats.count << setw( 12 ) << stats.cycles << fixed << setprecision( 2 ) << ( stats.cycles * cyclePercent ) << std::endl;
+	}
+	debugStream << std::endl;
+
+	debugStream << "Mode              Count       Cycles      %" << std::endl;
+	for ( uint32_t mode = 0; mode < wtProfiler::AddrModeCount; ++mode )
+	{
+		const profileStat_t& stats = profile.addrModeStats[ mode ];
+		if ( stats.count == 0 ) {
+			continue;
+		}
+		debugStream << left << setw( 18 ) << AddrModeNames[ mode ] << setw( 12 ) << stats.count << setw( 12 ) << stats.cycles << ( stats.cycles * cyclePercent ) << std::endl;
+	}
+	debugStream << std::endl;
+
+	const uint32_t hotSpotCount = std::min( profile.hotSpotCount, maxHotSpots );
+
+	// Labels are the disassembly lines, which begin with the offset into the bank
+	std::map<int32_t, std::map<uint32_t, string>> bankLabels;
+	for ( uint32_t i = 0; i < hotSpotCount; ++i )
+	{
+		const profileHotSpot_t& hotSpot = profile.hotSpots[ i ];
+		if ( ( hotSpot.bank < 0 ) || ( bankLabels.find( hotSpot.bank ) != bankLabels.end() ) ) {
+			continue;
+		}
+
+		std::map<uint32_t, string>& labels = bankLabels[ hotSpot.bank ];
+		std::stringstream bankAsm( GetPrgBankDissambly( static_cast<uint8_t>( hotSpot.bank ) ) );
+		string line;
+		while ( std::getline( bankAsm, line ) )
+		{
+			if ( line.size() > 8 ) {
+				labels[ std::stoul( line.substr( 2, 4 ), nullptr, 16 ) ] = line.substr( 8 );
+			}
+		}
+	}
+
+	debugStream << "Bank  Addr    Count       Cycles      %       Instruction" << std::endl;
+	for ( uint32_t i = 0; i < hotSpotCount; ++i )
+	{
+		const profileHotSpot_t& hotSpot = profile.hotSpots[ i ];
+		debugStream << right << setfill( '0' ) << uppercase << hex;
+		if ( hotSpot.bank >= 0 ) {
+			debugStream << setw( 2 ) << hotSpot.bank << "    ";
+		} else {
+			debugStream << "--    ";
+		}
+		debugStream << "0x" << setw( 4 ) << hotSpot.address << setfill( ' ' ) << dec << "  " << left;
+		debugStream << setw( 12 ) << hotSpot.stats.count << setw( 12 ) << hotSpot.stats.cycles << setw( 8 ) << ( hotSpot.stats.cycles * cyclePercent );
+
+		if ( hotSpot.bank >= 0 )
+		{
+			const std::map<uint32_t, string>& labels = bankLabels[ hotSpot.bank ];
+			const auto label = labels.find( hotSpot.address );
+			if ( label != labels.end() ) {
+				debugStream << label->second;
+			}
+		}
+		debugStream << std::endl;
+	}
+
+	return debugStream.str();
+}
+
+
 void wtSystem::GenerateRomDissambly( string prgRomAsm[ 128 ] )
 {
 	assert( cart->h.prgRomBanks <= 128 );
@@ -674,17 +1113,11 @@ void wtSystem::GenerateRomDissambly( string prgRomAsm[ 128 ] )
 
 void wtSystem::GetChrRomPalette( const uint8_t paletteId, RGBA palette[ 4 ] )
 {
-	const uint16_t baseAddr = ( paletteId > 3 ) ? PPU::SpritePaletteAddr : PPU::PaletteBaseAddr;
-	const uint16_t baseOffset = 4 * ( paletteId % 4 );
-	const uint8_t p0 = ppu.ReadVram( baseAddr + baseOffset + 0 );
-	const uint8_t p1 = ppu.ReadVram( baseAddr + baseOffset + 1 );
-	const uint8_t p2 = ppu.ReadVram( baseAddr + baseOffset + 2 );
-	const uint8_t p3 = ppu.ReadVram( baseAddr + baseOffset + 3 );
-
-	palette[ 0 ] = ppu.palette[ p0 ];
-	palette[ 1 ] = ppu.palette[ p1 ];
-	palette[ 2 ] = ppu.palette[ p2 ];
-	palette[ 3 ] = ppu.palette[ p3 ];
+	// Background palettes are 0-3 and sprite palettes 4-7, the same order as the PPU's palette cache
+	const uint8_t baseIx = 4 * ( paletteId % 8 );
+	for ( uint8_t colorIx = 0; colorIx < 4; ++colorIx ) {
+		palette[ colorIx ] = ppu.GetResolvedColor( baseIx + colorIx );
+	}
 }
 
 
@@ -739,6 +1172,7 @@ void wtSystem::RunStateControl( const bool toggledFrame )
 			if( state.IsValid() )
 			{
 				GetBackbuffer()->Clear();
+				GetIndexedBackbuffer()->Clear();
 				RestoreState( states[ playbackState.currentFrame ] );
 				playbackState.currentFrame += playbackState.pause ? 0 : 1;
 			}
@@ -778,10 +1212,7 @@ void wtSystem::RunStateControl( const bool toggledFrame )
 void wtSystem::UpdateDebugImages()
 {
 	RGBA palette[ 4 ];
-	for ( uint32_t i = 0; i < 4; ++i )
-	{
-		palette[ i ] = ppu.palette[ ppu.ReadVram( PPU::PaletteBaseAddr + i ) ];
-	}
+	GetChrRomPalette( 0, palette );
 
 	RGBA pickedPalette[ 4 ];
 	GetChrRomPalette( ( ppu.dbgInfo.spritePicked.palette >> 2 ) + 4, pickedPalette );
@@ -805,6 +1236,40 @@ void wtSystem::SaveFrameState()
 }
 
 
+void wtSystem::PickSprite()
+{
+	const wtPoint& point = input.mousePoint;
+	if ( ( point.x < 0 ) || ( point.x >= PPU::ScreenWidth ) || ( point.y < 0 ) || ( point.y >= PPU::ScreenHeight ) ) {
+		return;
+	}
+
+	const uint8_t oamIndex = spriteIdBuffer.Get( point.x + point.y * PPU::ScreenWidth );
+	if ( oamIndex == PPU::NoSpriteId ) {
+		return;
+	}
+
+	// The picked object image is drawn from spritePicked by UpdateDebugImages on the worker thread
+	ppu.PickSprite( oamIndex, static_cast<uint8_t>( point.y ) );
+
+	// Palette indices have no inverse color, the indexed output only records the pick
+	if ( config->ppu.indexedFrameBuffer ) {
+		return;
+	}
+
+	wtDisplayImage& image = frameBuffer[ finishedFrameIx ];
+	for ( uint32_t imageIx = 0; imageIx < image.GetBufferLength(); ++imageIx )
+	{
+		if ( spriteIdBuffer.Get( imageIx ) == oamIndex )
+		{
+			Pixel pixelColor = image.Get( imageIx );
+			pixelColor.rawABGR = ~pixelColor.rawABGR;
+			pixelColor.rgba.alpha = 0xFF;
+			image.Set( imageIx, pixelColor );
+		}
+	}
+}
+
+
 void wtSystem::ToggleFrame()
 {
 	finishedFrameIx = currentFrameIx;
@@ -813,6 +1278,13 @@ void wtSystem::ToggleFrame()
 	// Debug code. Should never see red flashes in final display
 	frameBuffer[ currentFrameIx ].Clear( 0xFF0000FF );
 #endif
+	if ( vramHeatmap != nullptr ) {
+		vramHeatmap->EndFrame();
+		vramHeatmap->DrawImage( vramHeatmapImage );
+	}
+	if ( config->ppu.spriteIdBuffer ) {
+		PickSprite();
+	}
 	frameNumber++;
 	toggledFrame = true;
 	frameTogglesPerRun++;
@@ -855,6 +1327,8 @@ int wtSystem::RunEpoch( const std::chrono::nanoseconds& runEpoch )
 	previousFrameNumber = frameNumber;
 
 	dbgInfo.cycleBegin = sysCycles;
+	memset( dbgInfo.syncCount, 0, sizeof( dbgInfo.syncCount ) );
+	const uint64_t skippedBegin = cpu.skippedCycles;
 
 	Timer emuTime;
 	emuTime.Start();
@@ -865,6 +1339,7 @@ int wtSystem::RunEpoch( const std::chrono::nanoseconds& runEpoch )
 	overflowCycles += ( endCycle - nextCycle ).count();
 
 	dbgInfo.cycleEnd = endCycle;
+	dbgInfo.skippedCycles = static_cast<uint32_t>( cpu.skippedCycles - skippedBegin );
 
 	const double frameTimeUs = emuTime.GetElapsedUs();
 	dbgInfo.frameTimeUs = static_cast<uint32_t>( frameTimeUs );
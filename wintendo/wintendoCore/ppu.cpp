@@ -13,6 +13,7 @@
 #include "debug.h"
 #include "mos6502.h"
 #include "NesSystem.h"
+#include "ppu_composite.h"
 
 
 void PPU::WriteReg( const uint16_t addr, const uint8_t value )
@@ -51,12 +52,16 @@ void PPU::DMA( const uint16_t address )
 	{
 		primaryOAM[i] = system->ReadMemory( i + wtSystem::PageSize * static_cast<uint8_t>( address ) );
 	}
+	spriteBucketsDirty = true;
 }
 
 
 void PPU::PPUCTRL( const uint8_t value )
 {
+	const uint8_t prevSpriteMode = regCtrl.sem.sprite8x16Mode;
+
 	regCtrl.byte = value;
+	spriteBucketsDirty = spriteBucketsDirty || ( prevSpriteMode != regCtrl.sem.sprite8x16Mode );
 	regStatus.current.sem.lastReadLsb = ( value & 0x1F );
 
 	regT.sem.ntId = static_cast<uint8_t>( regCtrl.sem.ntId );
@@ -65,8 +70,15 @@ void PPU::PPUCTRL( const uint8_t value )
 
 void PPU::PPUMASK( const uint8_t value )
 {
+	const uint8_t paletteBits = 0xE1; // Emphasis and greyscale
+	const bool paletteChanged = ( ( regMask.byte ^ value ) & paletteBits ) != 0;
+
 	regMask.byte = value;
 	regStatus.current.sem.lastReadLsb = ( value & 0x1F );
+
+	if ( paletteChanged ) {
+		RefreshPaletteCache();
+	}
 }
 
 
@@ -101,6 +113,7 @@ void PPU::OAMDATA( const uint8_t value )
 	assert( 0 );
 
 	registers[PPUREG_OAMDATA] = value;
+	spriteBucketsDirty = true;
 
 	regStatus.current.sem.lastReadLsb = ( value & 0x1F );
 }
@@ -265,6 +278,38 @@ FORCE_INLINE void PPU::BgPipelineFetch( const uint64_t cycleCountAdjust )
 }
 
 
+FORCE_INLINE uint64_t PPU::BgPipelineFetchTile()
+{
+	// Eight dots of BgPipelineShiftRegisters() and BgPipelineFetch() at once, the pattern row
+	// comes from the tile cache. Returns the row with the tile's palette bits in every pixel.
+	BgPipelineFetch( 2 );
+	BgPipelineFetch( 4 );
+
+	const uint8_t row = regV.sem.fineY;
+	const chrTile_t& tile = GetChrTile8x8( plLatches.tileId, GetBgPatternTableId() );
+
+	plLatches.chrRom0 = tile.planes[ 0 ][ row ];
+	plLatches.chrRom1 = tile.planes[ 1 ][ row ];
+	plLatches.flags = 0x1;
+	AdvanceXScroll();
+
+	plShifts[curShift] = plLatches;
+
+	chrShifts[0] = ( chrShifts[0] << 8 ) | plLatches.chrRom0;
+	chrShifts[1] = ( chrShifts[1] << 8 ) | plLatches.chrRom1;
+
+	palShifts[0] = ( palLatch[0] & 0x1 ) ? 0xFF : 0x00;
+	palShifts[1] = ( palLatch[1] & 0x1 ) ? 0xFF : 0x00;
+
+	palLatch[0] = ( plLatches.attribId >> 2 ) & 0x01;
+	palLatch[1] = ( ( plLatches.attribId >> 2 ) & 0x2 ) >> 1;
+
+	curShift ^= 0x1;
+
+	return tile.rows[ row ] | ( plLatches.attribId * 0x0101010101010101ull );
+}
+
+
 uint8_t PPU::GetBgPatternTableId()
 {
 	return static_cast<uint8_t>( regCtrl.sem.bgTableId );
@@ -283,83 +328,189 @@ uint8_t PPU::GetNameTableId()
 }
 
 
-uint16_t PPU::StaticMirrorVram( uint16_t addr, uint32_t mirrorMode )
+void PPU::MapChrMemory( const uint16_t addr, const uint32_t size, uint8_t* readPtr, uint8_t* writePtr )
 {
-	// Major mirror
-	addr %= 0x4000;
+	assert( ( addr % VramPageSize ) == 0 );
+	assert( ( size % VramPageSize ) == 0 );
 
-	// Nametable Mirrors
-	if ( addr >= 0x3000 && addr < 0x3F00 )
-	{
-		addr -= 0x1000;
-	}
+	const uint32_t firstPage = ( addr / VramPageSize );
+	const uint32_t lastPage = firstPage + ( size / VramPageSize );
+	assert( lastPage <= ChrPageCount );
 
-	// Nametable Mirroring Modes
-	if ( mirrorMode == MIRROR_MODE_HORIZONTAL )
+	for ( uint32_t page = firstPage; page < lastPage; ++page )
 	{
-		if ( addr >= 0x2400 && addr < 0x2800 ) {
-			return ( addr - 0x2400 + PPU::NameTable0BaseAddr );
-		} else if ( addr >= 0x2800 && addr < 0x2C00 ) {
-			return ( addr - 0x2800 + PPU::NameTable1BaseAddr );
-		} else if ( addr >= 0x2C00 && addr < 0x3000 ) {
-			return ( addr - 0x2C00 + PPU::NameTable1BaseAddr );
+		const uint32_t pageOffset = ( page - firstPage ) * VramPageSize;
+		uint8_t* pageReadPtr = ( readPtr != nullptr ) ? ( readPtr + pageOffset ) : unmappedPage;
+		uint8_t* pageWritePtr = ( writePtr != nullptr ) ? ( writePtr + pageOffset ) : nullptr;
+
+		// Decoded tiles are only dropped for slots that now point somewhere else
+		if ( vramReadPages[ page ] != pageReadPtr ) {
+			InvalidateChrCache( page * VramPageSize, VramPageSize );
 		}
+
+		vramReadPages[ page ] = pageReadPtr;
+		vramWritePages[ page ] = pageWritePtr;
 	}
-	else if ( mirrorMode == MIRROR_MODE_VERTICAL )
-	{
-		if ( addr >= 0x2400 && addr < 0x2800 ) {
-			return ( addr - 0x2400 + PPU::NameTable1BaseAddr );
-		} else if ( addr >= 0x2800 && addr < 0x2C00 ) {
-			return ( addr - 0x2800 + PPU::NameTable0BaseAddr );
-		} else if ( addr >= 0x2C00 && addr < 0x3000 ) {
-			return ( addr - 0x2C00 + PPU::NameTable1BaseAddr );
-		}
+}
+
+
+void PPU::AttachVramHeatmap( wtVramHeatmap* heatmap )
+{
+	// Counts the address as written by the game, before nametable mirroring
+	vramHeatmap = heatmap;
+}
+
+
+void PPU::MapNameTables( const uint8_t mirrorMode )
+{
+	// Which half of nt backs each of the four logical nametables
+	uint8_t ntBanks[ 4 ] = { 0, 0, 1, 1 };
+	if ( mirrorMode == MIRROR_MODE_VERTICAL ) {
+		ntBanks[ 1 ] = 1;
+		ntBanks[ 2 ] = 0;
+	} else if ( ( mirrorMode == MIRROR_MODE_FOURSCREEN ) || ( mirrorMode == MIRROR_MODE_SINGLE ) || ( mirrorMode == MIRROR_MODE_SINGLE_LO ) ) {
+		ntBanks[ 2 ] = 0;
+		ntBanks[ 3 ] = 0;
+	} else if ( mirrorMode == MIRROR_MODE_SINGLE_HI ) {
+		ntBanks[ 0 ] = 1;
+		ntBanks[ 1 ] = 1;
 	}
-	else if ( mirrorMode == MIRROR_MODE_FOURSCREEN )
+
+	// $3000-$3EFF repeats the nametables
+	const uint32_t firstPage = ( NameTable0BaseAddr / VramPageSize );
+	for ( uint32_t page = firstPage; page < VramPageCount; ++page )
 	{
-		if ( addr >= PPU::NameTable0BaseAddr && addr < 0x3000 )
-		{
-			return PPU::NameTable0BaseAddr + ( addr % PPU::NameTableAttribMemorySize );
-		}
+		uint8_t* bank = &nt[ ntBanks[ ( page - firstPage ) % 4 ] * NameTableAttribMemorySize ];
+		vramReadPages[ page ] = bank;
+		vramWritePages[ page ] = bank;
 	}
+	ntViewStale.store( true, std::memory_order_release );
+}
+
+
+FORCE_INLINE uint8_t PPU::PaletteIndex( const uint16_t addr )
+{
+	// $3F20-$3FFF repeat the palette and $3F10/$3F14/$3F18/$3F1C mirror the background entries
+	uint8_t paletteIx = ( addr & 0x1F );
+	if ( ( paletteIx & 0x13 ) == 0x10 ) {
+		paletteIx &= 0x0F;
+	}
+	return paletteIx;
+}
+
+
+FORCE_INLINE uint8_t& PPU::PaletteEntry( const uint16_t addr )
+{
+	const uint8_t paletteIx = PaletteIndex( addr );
+	return ( paletteIx < PaletteColorNumber ) ? imgPal[ paletteIx ] : sprPal[ paletteIx - PaletteColorNumber ];
+}
+
+
+FORCE_INLINE void PPU::ResolvePaletteEntry( const uint8_t paletteIx )
+{
+	// Entries with a zero color index resolve to the backdrop at $3F00, as the background draws them
+	const uint8_t greyscaleMask = regMask.sem.greyscale ? 0x30 : 0x3F;
+	const uint8_t entry = ( ( paletteIx & 0x03 ) == 0 ) ? imgPal[ 0 ] : PaletteEntry( PaletteBaseAddr + paletteIx );
 
-	// Palette Mirrors
-	if ( addr >= 0x3F20 && addr < 0x4000 )
+	const uint8_t colorIx = entry & greyscaleMask;
+	const bool changed = ( resolvedColors[ paletteIx ] != emphasizedColors[ colorIx ] );
+
+	resolvedIndices[ paletteIx ] = colorIx;
+	resolvedColors[ paletteIx ] = emphasizedColors[ colorIx ];
+
+	if ( changed ) {
+		MarkDebugViewsStale();
+	}
+}
+
+
+void PPU::MarkDebugViewsStale()
+{
+	ntViewStale.store( true, std::memory_order_release );
+	patternViewStale[ 0 ].store( true, std::memory_order_release );
+	patternViewStale[ 1 ].store( true, std::memory_order_release );
+}
+
+
+void PPU::TakeDebugFlags( std::atomic<bool>* flags, bool* taken, const uint32_t count )
+{
+	// A flag set after its exchange stays set for the next draw, clearing the whole set at once would drop it
+	for ( uint32_t i = 0; i < count; ++i )
 	{
-		addr = PPU::PaletteBaseAddr + ( ( addr & 0x00FF ) % 0x20 );
+		const bool wasSet = flags[ i ].exchange( false, std::memory_order_acquire );
+		if ( taken != nullptr ) {
+			taken[ i ] = wasSet;
+		}
 	}
+}
+
 
-	if ( ( addr == 0x3F10 ) || ( addr == 0x3F14 ) || ( addr == 0x3F18 ) || ( addr == 0x3F1C ) )
+void PPU::RefreshPaletteCache()
+{
+	// Rebuilt when PPUMASK changes the greyscale or emphasis bits, so pixel output is a single table lookup
+	const uint8_t emphasis = ( regMask.byte >> 5 );
+	for ( uint32_t colorIx = 0; colorIx < 64; ++colorIx )
 	{
-		return ( addr - 0x0010 );
+		Pixel pixel;
+		pixel.rgba = EmphasizeColor( palette[ colorIx ], emphasis );
+		emphasizedColors[ colorIx ] = pixel.rawABGR;
 	}
 
-	return addr;
+	for ( uint8_t paletteIx = 0; paletteIx < PaletteCacheSize; ++paletteIx ) {
+		ResolvePaletteEntry( paletteIx );
+	}
 }
 
 
-void PPU::GenerateMirrorMap()
+void PPU::UpdatePaletteCache( const uint8_t paletteIx )
 {
-#if MIRROR_OPTIMIZATION
-	for ( uint16_t mode = 0; mode < MIRROR_MODE_COUNT; ++mode )
+	// Palette RAM writes only touch the entries that read the written byte
+	if ( paletteIx == 0 )
 	{
-		for ( uint32_t addr = 0; addr < PPU::VirtualMemorySize; ++addr )
-		{
-			MirrorMap[mode][addr] = StaticMirrorVram( addr, mode );
+		for ( uint8_t backdropIx = 0; backdropIx < PaletteCacheSize; backdropIx += 4 ) {
+			ResolvePaletteEntry( backdropIx );
 		}
 	}
-#endif
+	else if ( ( paletteIx & 0x03 ) != 0 )
+	{
+		ResolvePaletteEntry( paletteIx );
+	}
 }
 
-FORCE_INLINE uint16_t PPU::MirrorVram( uint16_t addr )
+
+RGBA PPU::GetResolvedColor( const uint8_t paletteIx ) const
 {
-	uint32_t mirrorMode = system->GetMirrorMode();
+	assert( paletteIx < PaletteCacheSize );
 
-#if MIRROR_OPTIMIZATION
-	return MirrorMap[mirrorMode][addr];
-#else
-	return StaticMirrorVram( addr, mirrorMode );
-#endif
+	Pixel pixel;
+	pixel.rawABGR = resolvedColors[ paletteIx % PaletteCacheSize ];
+	return pixel.rgba;
+}
+
+
+RGBA PPU::EmphasizeColor( const RGBA& color, const uint8_t emphasis )
+{
+	// Emphasis bits are red, green, blue from bit 0. Each darkens the other two channels.
+	uint32_t scale[ 3 ] = { 256, 256, 256 };
+	for ( uint32_t bit = 0; bit < 3; ++bit )
+	{
+		if ( ( emphasis & BIT_MASK( bit ) ) == 0 ) {
+			continue;
+		}
+
+		for ( uint32_t channel = 0; channel < 3; ++channel )
+		{
+			if ( channel != bit ) {
+				scale[ channel ] = ( scale[ channel ] * EmphasisAttenuation ) >> 8;
+			}
+		}
+	}
+
+	RGBA result = color;
+	result.red		= static_cast<uint8_t>( ( color.red * scale[ 0 ] ) >> 8 );
+	result.green	= static_cast<uint8_t>( ( color.green * scale[ 1 ] ) >> 8 );
+	result.blue		= static_cast<uint8_t>( ( color.blue * scale[ 2 ] ) >> 8 );
+	return result;
 }
 
 
@@ -446,6 +597,75 @@ uint8_t PPU::GetChrRomPalette( const uint8_t plane0, const uint8_t plane1, const
 }
 
 
+uint64_t PPU::DecodeChrRow( const uint8_t plane0, const uint8_t plane1, const bool flipped )
+{
+	uint64_t pixels = 0;
+	for ( uint8_t col = 0; col < TilePixels; ++col )
+	{
+		const uint64_t pixel = GetChrRomPalette( plane0, plane1, col );
+		const uint8_t pixelX = flipped ? ( 7 - col ) : col;
+		pixels |= pixel << ( 8 * pixelX );
+	}
+	return pixels;
+}
+
+
+void PPU::DecodeChrTile( const uint32_t tileIx )
+{
+	chrTile_t& tile = chrTileCache[ tileIx ];
+	const uint16_t chrAddr = static_cast<uint16_t>( tileIx * ChrTileBytes );
+
+	for ( uint8_t row = 0; row < TilePixels; ++row )
+	{
+		const uint8_t plane0 = ReadVram( chrAddr + row );
+		const uint8_t plane1 = ReadVram( chrAddr + row + TilePixels );
+
+		tile.planes[ 0 ][ row ] = plane0;
+		tile.planes[ 1 ][ row ] = plane1;
+		tile.rows[ row ] = DecodeChrRow( plane0, plane1, false );
+		tile.flippedRows[ row ] = DecodeChrRow( plane0, plane1, true );
+	}
+
+	chrTileValid[ tileIx ] = true;
+}
+
+
+FORCE_INLINE const chrTile_t& PPU::GetChrTile( const uint16_t chrAddr )
+{
+	const uint32_t tileIx = ( chrAddr / ChrTileBytes ) % ChrTileCount;
+	if ( !chrTileValid[ tileIx ] ) {
+		DecodeChrTile( tileIx );
+	}
+	return chrTileCache[ tileIx ];
+}
+
+
+FORCE_INLINE const chrTile_t& PPU::GetChrTile8x8( const uint32_t tileId, const uint8_t ptrnTableId )
+{
+	return GetChrTile( ( ptrnTableId << 12 ) | ( tileId << 4 ) );
+}
+
+
+FORCE_INLINE const chrTile_t& PPU::GetChrTile8x16( const uint32_t tileId, const uint8_t isUpper )
+{
+	return GetChrTile( ( ( tileId & 0x01 ) << 12 ) | ( ( ( tileId & ~0x01 ) | isUpper ) << 4 ) );
+}
+
+
+void PPU::InvalidateChrCache( const uint16_t addr, const uint32_t size )
+{
+	// Called for CHR RAM writes and mapper bank switches, tiles are decoded again on their next fetch
+	const uint32_t firstTile = addr / ChrTileBytes;
+	const uint32_t lastTile = ( addr + size - 1 ) / ChrTileBytes;
+
+	for ( uint32_t tileIx = firstTile; ( tileIx <= lastTile ) && ( tileIx < ChrTileCount ); ++tileIx ) {
+		chrTileValid[ tileIx ] = false;
+		ntViewChrDirty[ tileIx ].store( true, std::memory_order_release );
+		patternViewChrDirty[ tileIx ].store( true, std::memory_order_release );
+	}
+}
+
+
 bool PPU::IsMemoryMapped( const uint16_t addr ) const
 {
 	return false;
@@ -454,21 +674,12 @@ bool PPU::IsMemoryMapped( const uint16_t addr ) const
 
 FORCE_INLINE uint8_t PPU::ReadVram( const uint16_t addr )
 {
-	const uint16_t adjustedAddr = MirrorVram( addr );
-	assert( adjustedAddr < VirtualMemorySize );
+	const uint16_t vramAddr = ( addr % PhysicalMemorySize );
 
-	if( InRange( adjustedAddr, 0x0000, 0x1FFF ) ) {
-		return system->cart->mapper->ReadChrRom( adjustedAddr );
-	} else if ( InRange( adjustedAddr, 0x2000, 0x3EFF ) ) {
-		return nt[ adjustedAddr - 0x2000 ];
-	} else if ( InRange( adjustedAddr, 0x3F00, 0x3F0F ) ) {
-		return imgPal[ adjustedAddr - 0x3F00 ];
-	} else if ( InRange( adjustedAddr, 0x3F10, 0x3F1F ) ) {
-		return sprPal[ adjustedAddr - 0x3F10 ];
-	} else {
-		assert( 0 );
-		return 0;
+	if ( vramAddr < PaletteBaseAddr ) {
+		return vramReadPages[ vramAddr / VramPageSize ][ vramAddr % VramPageSize ];
 	}
+	return PaletteEntry( vramAddr );
 }
 
 
@@ -476,22 +687,32 @@ void PPU::WriteVram()
 {
 	if ( vramWritePending && DataportEnabled()  )
 	{
-		const uint16_t adjustedAddr = MirrorVram( regV.byte2x );
-		// assert( adjustedAddr < PhysicalMemorySize );
-
-		if ( InRange( adjustedAddr, 0x0000, 0x1FFF ) ) {
-			system->cart->mapper->WriteChrRam( adjustedAddr, registers[ PPUREG_DATA ] );
-		} else if ( InRange( adjustedAddr, 0x2000, 0x3EFF ) ) {
-			nt[ adjustedAddr - 0x2000 ] = registers[ PPUREG_DATA ];
-		} else if ( InRange( adjustedAddr, 0x3F00, 0x3F0F ) ) {
-			imgPal[ adjustedAddr - 0x3F00 ] = registers[ PPUREG_DATA ];
-		} else if ( InRange( adjustedAddr, 0x3F10, 0x3F1F ) ) {
-			sprPal[ adjustedAddr - 0x3F10 ] = registers[ PPUREG_DATA ];
-		} else {
-			assert( 0 );
+		const uint16_t vramAddr = ( regV.byte2x % PhysicalMemorySize );
+
+		if ( vramAddr >= PaletteBaseAddr )
+		{
+			PaletteEntry( vramAddr ) = registers[ PPUREG_DATA ];
+			UpdatePaletteCache( PaletteIndex( vramAddr ) );
+		}
+		else
+		{
+			uint8_t* page = vramWritePages[ vramAddr / VramPageSize ];
+			if ( page != nullptr ) {
+				page[ vramAddr % VramPageSize ] = registers[ PPUREG_DATA ];
+			}
+
+			if ( vramAddr >= NameTable0BaseAddr ) {
+				ntViewDirty[ &page[ vramAddr % VramPageSize ] - nt ].store( true, std::memory_order_release );
+			}
+
+			if ( vramAddr < PatternTableMemorySize ) {
+				InvalidateChrCache( vramAddr, 1 );
+			}
 		}
 
-		debugVramWriteCounter[adjustedAddr]++;
+		if ( vramHeatmap != nullptr ) {
+			vramHeatmap->Record( vramAddr );
+		}
 	}
 
 	vramWritePending = false;
@@ -535,33 +756,25 @@ uint8_t PPU::BgPipelineDecodePalette()
 
 void PPU::DrawTile( wtNameTableImage& imageBuffer, const wtRect& imageRect, const wtPoint& nametableTile, const uint32_t ntId, const uint32_t ptrnTableId )
 {
+	const uint32_t tileIx = GetNtTile( ntId, nametableTile );
+
+	const uint8_t attribute	= GetArribute( ntId, nametableTile );
+	const uint8_t paletteId	= GetTilePaletteId( attribute, nametableTile );
+
+	const chrTile_t& tile = GetChrTile8x8( tileIx, ptrnTableId );
+
 	for ( uint32_t y = 0; y < PPU::TilePixels; ++y )
 	{
 		for ( uint32_t x = 0; x < PPU::TilePixels; ++x )
 		{
-			wtPoint chrRomPoint;
-
-			const uint32_t tileIx = GetNtTile( ntId, nametableTile );
-
-			const uint8_t attribute	= GetArribute( ntId, nametableTile );
-			const uint8_t paletteId	= GetTilePaletteId( attribute, nametableTile );
-
-			chrRomPoint.x = x;
-			chrRomPoint.y = y;
-
-			const uint8_t chrRom0 = GetChrRom8x8( tileIx, 0, ptrnTableId, chrRomPoint.y );
-			const uint8_t chrRom1 = GetChrRom8x8( tileIx, 1, ptrnTableId, chrRomPoint.y );
-
-			const uint16_t chrRomColor = GetChrRomPalette( chrRom0, chrRom1, chrRomPoint.x );
+			const uint8_t chrRomColor = ( tile.rows[ y ] >> ( 8 * x ) ) & 0x03;
 			const uint8_t finalPalette = paletteId | chrRomColor;
 
 			const uint32_t imageX = imageRect.x + x;
 			const uint32_t imageY = imageRect.y + y;
 
-			const uint8_t colorIx = chrRomColor == 0 ? ReadVram( PPU::PaletteBaseAddr ) : ReadVram( PPU::PaletteBaseAddr + finalPalette );
-
 			Pixel pixelColor;
-			pixelColor.rgba = palette[colorIx];
+			pixelColor.rawABGR = resolvedColors[ finalPalette ];
 			imageBuffer.Set( imageX + imageY * imageRect.width, pixelColor );
 		}
 	}
@@ -580,31 +793,21 @@ void PPU::DrawChrRomTile( wtRawImageInterface* imageBuffer, const wtRect& imageR
 			chrRomPoint.x = x;
 			chrRomPoint.y = y;
 
-			uint8_t chrRom0;
-			uint8_t chrRom1;
+			uint16_t chrRomColor;
 
 			if( cartBank )
 			{
 				assert( !is8x16 );
-				chrRom0 = GetChrRomBank8x8( tileId, 0, tableId, chrRomPoint.y );
-				chrRom1 = GetChrRomBank8x8( tileId, 1, tableId, chrRomPoint.y );
+				const uint8_t chrRom0 = GetChrRomBank8x8( tileId, 0, tableId, chrRomPoint.y );
+				const uint8_t chrRom1 = GetChrRomBank8x8( tileId, 1, tableId, chrRomPoint.y );
+				chrRomColor = GetChrRomPalette( chrRom0, chrRom1, chrRomPoint.x );
 			}
 			else
 			{
-				if ( is8x16 )
-				{
-					chrRom0 = GetChrRom8x16( tileId, 0, chrRomPoint.y, isUpper );
-					chrRom1 = GetChrRom8x16( tileId, 1, chrRomPoint.y, isUpper );
-				}
-				else
-				{
-					chrRom0 = GetChrRom8x8( tileId, 0, tableId, chrRomPoint.y );
-					chrRom1 = GetChrRom8x8( tileId, 1, tableId, chrRomPoint.y );
-				}
+				const chrTile_t& tile = is8x16 ? GetChrTile8x16( tileId, isUpper ) : GetChrTile8x8( tileId, tableId );
+				chrRomColor = ( tile.rows[ chrRomPoint.y ] >> ( 8 * chrRomPoint.x ) ) & 0x03;
 			}
 
-			const uint16_t chrRomColor = GetChrRomPalette( chrRom0, chrRom1, chrRomPoint.x );
-
 			const uint32_t imageX = imageRect.x + x;
 			const uint32_t imageY = imageRect.y + y;
 
@@ -634,23 +837,12 @@ spriteAttrib_t PPU::GetSpriteData( const uint8_t spriteId, const uint8_t oam[] )
 }
 
 
-bool PPU::DrawSpritePixel( wtDisplayImage& fb, const spriteAttrib_t attribs, const ppuImageIx_t& beam, const uint8_t bgPixel )
+FORCE_INLINE uint64_t PPU::GetSpriteChrRow( const spriteAttrib_t& attribs, const int32_t spriteY )
 {
-	Pixel pixelColor;
-
-	wtPoint spritePt;
-
-	spritePt.x = beam.point.x - attribs.x;
-	spritePt.y = beam.point.y - attribs.y;
-	spritePt.x = attribs.flippedHorizontal	? ( 7 - spritePt.x ) : spritePt.x;
-
-	uint8_t chrRom0 = 0;
-	uint8_t chrRom1 = 0; 
-
 	if ( regCtrl.sem.sprite8x16Mode )
 	{
-		bool isUpper = ( spritePt.y >= 8 );
-		uint8_t row = ( spritePt.y % 8 );
+		bool isUpper = ( spriteY >= 8 );
+		uint8_t row = ( spriteY % 8 );
 
 		if ( attribs.flippedVertical )
 		{
@@ -658,67 +850,36 @@ bool PPU::DrawSpritePixel( wtDisplayImage& fb, const spriteAttrib_t attribs, con
 			isUpper = !isUpper;
 		}
 
-		chrRom0 = GetChrRom8x16( attribs.tileId, 0, row, isUpper );
-		chrRom1 = GetChrRom8x16( attribs.tileId, 1, row, isUpper );
+		const chrTile_t& tile = GetChrTile8x16( attribs.tileId, isUpper );
+		return attribs.flippedHorizontal ? tile.flippedRows[ row ] : tile.rows[ row ];
 	}
 	else
 	{
-		spritePt.y = attribs.flippedVertical ? ( 7 - spritePt.y ) : spritePt.y;
+		const uint8_t row = attribs.flippedVertical ? ( 7 - spriteY ) : spriteY;
 
-		chrRom0 = GetChrRom8x8( attribs.tileId, 0, GetSpritePatternTableId(), spritePt.y );
-		chrRom1 = GetChrRom8x8( attribs.tileId, 1, GetSpritePatternTableId(), spritePt.y );
+		const chrTile_t& tile = GetChrTile8x8( attribs.tileId, GetSpritePatternTableId() );
+		return attribs.flippedHorizontal ? tile.flippedRows[ row ] : tile.rows[ row ];
 	}
-
-	const uint8_t finalPalette = GetChrRomPalette( chrRom0, chrRom1, spritePt.x );
-
-	const uint8_t colorIx = ReadVram( SpritePaletteAddr + attribs.palette + finalPalette );
-
-	// Sprite 0 Hit happens regardless of priority but still draws normal
-	if ( attribs.sprite0 )
-	{
-		if ( ( bgPixel != 0 ) && ( finalPalette != 0 ) && ( regMask.sem.showBg ) )
-		{
-			regStatus.current.sem.spriteHit = true;
-		}
-	}
-
-	if ( finalPalette == 0x00 ) {
-		return false;
-	}
-
-	if ( ( attribs.priority == 1 ) && ( bgPixel != 0 ) ) {
-		return true;
-	}
-
-	if( !system->GetConfig()->ppu.showSprite ) {
-		return true;
-	}
-
-	pixelColor.rgba = palette[colorIx];
-
-	uint8_t spriteHeight = regCtrl.sem.sprite8x16Mode ? 16 : 8;
-	if ( system->MouseInRegion( { attribs.x, attribs.y, attribs.x + 8, attribs.y + spriteHeight } ) )
-	{
-		pixelColor.rawABGR = ~pixelColor.rawABGR;
-		pixelColor.rgba.alpha = 0xFF;
-		
-		dbgInfo.spritePicked = attribs;
-		fb.Set( beam.index, pixelColor );
-	}
-	else
-	{
-		fb.Set( beam.index, pixelColor );
-	}
-
-	return true;
 }
 
 
 void PPU::DrawDebugPatternTables( wtPatternTableImage& imageBuffer, const RGBA dbgPalette[4], const uint32_t tableID, const bool isCartbank )
 {
+	// Cart banks aren't tracked, only the mapped tables keep dirty state for redraws
+	bool chrDirty[ TilesPerPatternTable ];
+	bool redrawAll = true;
+	if ( !isCartbank )
+	{
+		redrawAll = patternViewStale[ tableID % 2 ].exchange( false, std::memory_order_acquire );
+		TakeDebugFlags( &patternViewChrDirty[ ( tableID % 2 ) * TilesPerPatternTable ], chrDirty, TilesPerPatternTable );
+	}
+
 	for ( int32_t tileY = 0; tileY < 16; ++tileY ) {
 		for ( int32_t tileX = 0; tileX < 16; ++tileX ) {
-			DrawChrRomTile( &imageBuffer, wtRect{ (int32_t)PPU::TilePixels * tileX, (int32_t)PPU::TilePixels * tileY, PPU::PatternTableWidth, PPU::PatternTableHeight }, dbgPalette, (int32_t)( tileX + 16 * tileY ), tableID, isCartbank );
+			const uint32_t tileId = tileX + 16 * tileY;
+			if ( redrawAll || chrDirty[ tileId ] ) {
+				DrawChrRomTile( &imageBuffer, wtRect{ (int32_t)PPU::TilePixels * tileX, (int32_t)PPU::TilePixels * tileY, PPU::PatternTableWidth, PPU::PatternTableHeight }, dbgPalette, tileId, tableID, isCartbank );
+			}
 		}
 	}
 }
@@ -737,69 +898,119 @@ void PPU::DrawDebugObject( wtRawImageInterface* imageBuffer, const RGBA dbgPalet
 
 void PPU::DrawDebugNametable( wtNameTableImage& imageBuffer )
 {
-	wtRect ntRects[4] = {		{ 0,			0,					2 * ScreenWidth,	2 * ScreenHeight },
-								{ ScreenWidth,	0,					2 * ScreenWidth,	2 * ScreenHeight },
-								{ 0,			ScreenHeight,		2 * ScreenWidth,	2 * ScreenHeight },
-								{ ScreenWidth,	ScreenHeight,		2 * ScreenWidth,	2 * ScreenHeight }, };
+	// Take the dirty sets before reading VRAM, anything marked after this is drawn next time
+	bool ntDirty[ KB(2) ];
+	bool chrDirty[ ChrTileCount ];
+	TakeDebugFlags( ntViewDirty, ntDirty, KB(2) );
+	TakeDebugFlags( ntViewChrDirty, chrDirty, ChrTileCount );
 
-	wtPoint ntCorners[4] = {	{ 0,			0 },
-								{ ScreenWidth,	0 },
-								{ 0,			ScreenHeight },
-								{ ScreenWidth,	ScreenHeight }, };
+	const uint8_t ptrnTableId = GetBgPatternTableId();
+	const bool redrawAll = ntViewStale.exchange( false, std::memory_order_acquire ) || ( ntViewPatternTable != ptrnTableId );
+	const uint32_t firstPage = ( NameTable0BaseAddr / VramPageSize );
 
 	for ( uint32_t ntId = 0; ntId < 4; ++ntId )
 	{
+		// Mirrored nametables share a bank, so a write redraws every copy in the sheet
+		const uint32_t bankOffset = static_cast<uint32_t>( vramReadPages[ firstPage + ntId ] - nt );
+		const wtRect ntRect = { static_cast<int32_t>( ( ntId % 2 ) * ScreenWidth ), static_cast<int32_t>( ( ntId / 2 ) * ScreenHeight ), 2 * ScreenWidth, 2 * ScreenHeight };
+
 		for ( int32_t tileY = 0; tileY < (int)PPU::NameTableHeightTiles; ++tileY )
 		{
 			for ( int32_t tileX = 0; tileX < (int)PPU::NameTableWidthTiles; ++tileX )
 			{
-				DrawTile( imageBuffer, ntRects[ntId], wtPoint{ tileX, tileY }, ntId, GetBgPatternTableId() );
+				const uint32_t tileOffset = bankOffset + tileY * NameTableWidthTiles + tileX;
+				const uint32_t attribOffset = bankOffset + NametableMemorySize + ( tileY / NtTilesPerAttribute ) * AttribTableWidthTiles + ( tileX / NtTilesPerAttribute );
+				const uint32_t chrTileIx = ptrnTableId * TilesPerPatternTable + nt[ tileOffset ];
 
-				ntRects[ntId].x += static_cast<uint32_t>( PPU::TilePixels );
+				if ( redrawAll || ntDirty[ tileOffset ] || ntDirty[ attribOffset ] || chrDirty[ chrTileIx ] )
+				{
+					const wtRect tileRect = { ntRect.x + tileX * (int32_t)PPU::TilePixels, ntRect.y + tileY * (int32_t)PPU::TilePixels, ntRect.width, ntRect.height };
+					DrawTile( imageBuffer, tileRect, wtPoint{ tileX, tileY }, ntId, ptrnTableId );
+				}
 			}
-
-			ntRects[ntId].x = ntCorners[ntId].x;
-			ntRects[ntId].y += static_cast<uint32_t>( PPU::TilePixels );
 		}
 	}
+
+	ntViewPatternTable = ptrnTableId;
 }
 
 
 void PPU::DrawDebugPalette( wtPaletteImage& imageBuffer )
 {
-	for ( uint16_t colorIx = 0; colorIx < 16; ++colorIx )
+	// Shows the colors as drawn, so the first entry of every palette is the backdrop
+	for ( uint16_t paletteIx = 0; paletteIx < PaletteCacheSize; ++paletteIx )
 	{
 		Pixel pixel;
+		pixel.rawABGR = resolvedColors[ paletteIx ];
+		imageBuffer.Set( paletteIx, pixel );
+	}
+}
+
+
+void PPU::BuildSpriteBuckets()
+{
+	// Sorts OAM into the lines each sprite covers, only redone after OAM or the sprite size changes
+	memset( spriteBucketCount, 0, sizeof( spriteBucketCount ) );
+
+	const uint32_t spriteHeight = regCtrl.sem.sprite8x16Mode ? 16 : 8;
+
+	for ( uint8_t spriteNum = 0; spriteNum < TotalSprites; ++spriteNum )
+	{
+		const uint8_t y = 1 + primaryOAM[spriteNum * 4];
+		if ( ( y < 1 ) || (y > 232 ) ) {
+			continue;
+		}
+
+		const uint32_t lastLine = ( ( y + spriteHeight ) < ScreenHeight ) ? ( y + spriteHeight ) : ScreenHeight;
+		for ( uint32_t line = y; line < lastLine; ++line ) {
+			spriteBuckets[ line ][ spriteBucketCount[ line ]++ ] = spriteNum;
+		}
+	}
+
+	spriteBucketsDirty = false;
+}
+
+
+void PPU::RasterizeSpriteLine()
+{
+	memset( spriteLine, 0, sizeof( spriteLine ) );
+
+	// Back to front so the first opaque sprite in OAM order is left on top
+	for ( int32_t spriteIndex = secondaryOamSpriteCnt - 1; spriteIndex >= 0; --spriteIndex )
+	{
+		const spriteAttrib_t& attribs = secondaryOAM[ spriteIndex ];
+
+		uint8_t flags = CompositeSpritePalette | attribs.palette;
+		flags |= attribs.priority ? CompositeSpriteBehind : 0;
+		flags |= attribs.sprite0 ? CompositeSprite0 : 0;
 
-		uint32_t color = ReadVram( PaletteBaseAddr + colorIx );
-		pixel.rgba = palette[color];
-		imageBuffer.Set( colorIx, pixel );
+		const uint64_t row = GetSpriteChrRow( attribs, beam.point.y - attribs.y ) | ( flags * 0x0101010101010101ull );
+		const uint64_t opaque = ( ( row | ( row >> 1 ) ) & 0x0101010101010101ull ) * 0xFF;
 
-		color = ReadVram( SpritePaletteAddr + colorIx );
-		pixel.rgba = palette[color];
-		imageBuffer.Set( 16 + colorIx, pixel );
+		uint64_t pixels;
+		memcpy( &pixels, &spriteLine[ attribs.x ], sizeof( pixels ) );
+		pixels = ( pixels & ~opaque ) | ( row & opaque );
+		memcpy( &spriteLine[ attribs.x ], &pixels, sizeof( pixels ) );
 	}
 }
 
 
 FORCE_INLINE void PPU::LoadSecondaryOAM()
 {
+	if ( spriteBucketsDirty ) {
+		BuildSpriteBuckets();
+	}
+
 	uint8_t destSpriteNum = 0;
 	memset( &secondaryOAM, 0xFF, system->GetConfig()->ppu.spriteLimit );
 
-	for ( uint8_t spriteNum = 0; spriteNum < 64; ++spriteNum )
+	const uint32_t line = beam.point.y;
+	assert( line < ScreenHeight );
+
+	for ( uint8_t bucketIx = 0; bucketIx < spriteBucketCount[ line ]; ++bucketIx )
 	{
-		const uint8_t y = 1 + primaryOAM[spriteNum * 4];
+		const uint8_t spriteNum = spriteBuckets[ line ][ bucketIx ];
 		const bool isLargeSpriteMode = static_cast<bool>( regCtrl.sem.sprite8x16Mode );
-		const uint32_t spriteHeight = isLargeSpriteMode ? 16 : 8;
-
-		if ( ( beam.point.y >= static_cast<int32_t>( y + spriteHeight ) ) || ( beam.point.y < static_cast<int32_t>( y ) ) ) {
-			continue;
-		}
-
-		if ( ( y < 1 ) || (y > 232 ) ) {
-			continue;
-		}
 
 		secondaryOAM[destSpriteNum] = GetSpriteData( spriteNum, primaryOAM );
 		secondaryOAM[ destSpriteNum ].secondaryOamIndex = destSpriteNum;
@@ -814,6 +1025,8 @@ FORCE_INLINE void PPU::LoadSecondaryOAM()
 	}
 
 	secondaryOamSpriteCnt = destSpriteNum;
+
+	RasterizeSpriteLine();
 }
 
 
@@ -925,6 +1138,78 @@ ppuCycle_t PPU::GetCycle() const
 }
 
 
+ppuCycle_t PPU::NextVblankCycle() const
+{
+	return CycleAtScanline( 241, 1 );
+}
+
+
+ppuCycle_t PPU::CycleAtScanline( const int32_t scanline, const uint32_t dot ) const
+{
+	// Every scanline is exactly ScanlineCycles long and Exec() always lands on dot 0 of the next one,
+	// so future dots can be found without stepping. The pre-render line wraps back to scanline 1.
+	const uint64_t lineDot = cycle.count() % ScanlineCycles;
+	const uint64_t lineStart = cycle.count() - lineDot;
+
+	uint64_t lines = 0;
+	if ( scanline > currentScanline ) {
+		lines = scanline - currentScanline;
+	} else if ( scanline < currentScanline ) {
+		lines = ( PRERENDER_SCANLINE - currentScanline ) + scanline;
+	} else if ( lineDot > dot ) {
+		lines = PRERENDER_SCANLINE;
+	}
+
+	return ppuCycle_t( lineStart + lines * ScanlineCycles + dot );
+}
+
+
+ppuCycle_t PPU::NextSyncCycle( syncEvent_t& event ) const
+{
+	// Only work that the CPU can observe without touching a PPU register needs a sync point
+	ppuCycle_t nextCycle = CycleAtScanline( PRERENDER_SCANLINE, 1 );
+	event = SYNC_EVENT_FRAME_STATE;
+
+	if ( regCtrl.sem.nmiVblank )
+	{
+		const ppuCycle_t nmiCycle = CycleAtScanline( 241, 1 );
+		if ( nmiCycle < nextCycle )
+		{
+			nextCycle = nmiCycle;
+			event = SYNC_EVENT_NMI;
+		}
+	}
+
+	const bool renderEnabled = ( regMask.sem.showBg || regMask.sem.showSprt );
+	if ( renderEnabled && system->cart->mapper->IrqEnabled() )
+	{
+		const uint64_t lineDot = cycle.count() % ScanlineCycles;
+		const bool isFetchLine = ( currentScanline < POSTRENDER_SCANLINE ) || ( currentScanline == PRERENDER_SCANLINE );
+
+		int32_t clockScanline = currentScanline;
+		if ( !isFetchLine || ( lineDot > 260 ) )
+		{
+			if ( currentScanline == PRERENDER_SCANLINE ) {
+				clockScanline = 1;
+			} else if ( currentScanline < ( POSTRENDER_SCANLINE - 1 ) ) {
+				clockScanline = currentScanline + 1;
+			} else {
+				clockScanline = PRERENDER_SCANLINE;
+			}
+		}
+
+		const ppuCycle_t irqCycle = CycleAtScanline( clockScanline, 260 );
+		if ( irqCycle < nextCycle )
+		{
+			nextCycle = irqCycle;
+			event = SYNC_EVENT_MAPPER_IRQ;
+		}
+	}
+
+	return nextCycle;
+}
+
+
 void PPU::Render()
 {
 	const uint32_t imageIx = beam.index;
@@ -935,62 +1220,234 @@ void PPU::Render()
 	bgMask = bgMask || !regMask.sem.showBg;
 	bgMask = bgMask || !system->GetConfig()->ppu.showBG;
 
-	wtDisplayImage* fb = system->GetBackbuffer();
+	if ( !bgMask ) {
+		bgPixel = BgPipelineDecodePalette();
+	}
 
-	if ( bgMask )
-	{
-		Pixel pixelColor;
-		const uint8_t colorIx = ReadVram( PPU::PaletteBaseAddr );
+	// Frame Buffer, a masked background draws the backdrop from entry 0
+	OutputPixel( imageIx, bgPixel );
+
+	bgLine[ beam.point.x ] = bgPixel & 0x03;
+	DrawSprites( bgPixel );
+
+	++beam.index;
+}
 
-		pixelColor.rgba = palette[ colorIx ];
-		fb->Set( imageIx, pixelColor );	
+
+FORCE_INLINE void PPU::OutputPixel( const uint32_t imageIx, const uint8_t paletteIx )
+{
+	if ( indexedOutput )
+	{
+		system->GetIndexedBackbuffer()->Set( imageIx, resolvedIndices[ paletteIx ] );
 	}
 	else
 	{
-		bgPixel = BgPipelineDecodePalette();
+		Pixel pixelColor;
+		pixelColor.rawABGR = resolvedColors[ paletteIx ];
+		system->GetBackbuffer()->Set( imageIx, pixelColor );
+	}
+}
 
-		uint16_t finalPalette = bgPixel + PPU::PaletteBaseAddr;
 
-		const uint8_t colorIx = ( ( bgPixel & 0x03 ) == 0 ) ? ReadVram( PPU::PaletteBaseAddr ) : ReadVram( finalPalette );
+void PPU::BeginScanlineOutput()
+{
+	indexedOutput = system->GetConfig()->ppu.indexedFrameBuffer;
+	spriteIdOutput = system->GetConfig()->ppu.spriteIdBuffer;
+	if ( indexedOutput ) {
+		system->GetIndexedBackbuffer()->SetEmphasis( beam.point.y, regMask.byte >> 5 );
+	}
+}
 
-		// Frame Buffer
-		Pixel pixelColor;
-		pixelColor.rgba = palette[ colorIx ];
-		fb->Set( imageIx, pixelColor );
+
+FORCE_INLINE void PPU::DrawSprites( const uint8_t bgPixel )
+{
+	if ( !regMask.sem.showSprt || ( !regMask.sem.sprtLeft && ( beam.point.x < 8 ) ) ) {
+		return;
+	}
+
+	const uint8_t sprPixel = spriteLine[ beam.point.x ];
+	if ( ( sprPixel & 0x03 ) == 0 ) {
+		return;
+	}
+
+	const bool bgOpaque = ( bgPixel & 0x03 ) != 0;
+	if ( ( sprPixel & CompositeSprite0 ) && bgOpaque && regMask.sem.showBg ) {
+		regStatus.current.sem.spriteHit = true;
+	}
+
+	if ( ( ( sprPixel & CompositeSpriteBehind ) && bgOpaque ) || !system->GetConfig()->ppu.showSprite ) {
+		return;
 	}
 
-	uint8_t spriteCount = secondaryOamSpriteCnt;
-	if ( !regMask.sem.sprtLeft && ( beam.point.x < 8 ) ) {
-		spriteCount = 0;
+	OutputPixel( beam.index, sprPixel & CompositeColorMask );
+}
+
+
+void PPU::OutputSpriteIdLine( const uint8_t line )
+{
+	// Debug pass that runs once a line is finished, it repeats the sprite decisions of DrawSprites
+	// and CompositePixels to find the OAM index that won each pixel
+	uint8_t* spriteIds = system->GetSpriteIdBuffer()->GetRawBuffer() + line * ScreenWidth;
+	memset( spriteIds, NoSpriteId, ScreenWidth );
+
+	if ( !regMask.sem.showSprt || !system->GetConfig()->ppu.showSprite ) {
+		return;
 	}
 
-	for ( uint8_t spriteIndex = 0; spriteIndex < spriteCount; ++spriteIndex )
+	for ( int32_t spriteIndex = secondaryOamSpriteCnt - 1; spriteIndex >= 0; --spriteIndex )
 	{
-		spriteAttrib_t& attribs = secondaryOAM[ spriteIndex ];
-		if ( ( beam.point.x >= ( attribs.x + 8 ) ) || ( beam.point.x < attribs.x ) ) {
-			continue;
+		const spriteAttrib_t& attribs = secondaryOAM[ spriteIndex ];
+		const uint64_t row = GetSpriteChrRow( attribs, line - attribs.y );
+		for ( uint32_t pixelX = 0; ( pixelX < TilePixels ) && ( ( attribs.x + pixelX ) < ScreenWidth ); ++pixelX )
+		{
+			if ( ( ( row >> ( 8 * pixelX ) ) & 0x03 ) != 0 ) {
+				spriteIds[ attribs.x + pixelX ] = attribs.oamIndex;
+			}
 		}
+	}
 
-		if ( !regMask.sem.showSprt ) {
-			continue;
+	const uint32_t firstX = regMask.sem.sprtLeft ? 0 : TilePixels;
+	for ( uint32_t x = 0; x < ScreenWidth; ++x )
+	{
+		const bool behindBg = ( ( spriteLine[ x ] & CompositeSpriteBehind ) != 0 ) && ( bgLine[ x ] != 0 );
+		if ( ( x < firstX ) || behindBg ) {
+			spriteIds[ x ] = NoSpriteId;
 		}
+	}
+}
+
+
+void PPU::PickSprite( const uint8_t oamIndex, const uint8_t line )
+{
+	dbgInfo.spritePicked = GetSpriteData( oamIndex, primaryOAM );
+	dbgInfo.spritePicked.is8x16 = regCtrl.sem.sprite8x16Mode;
+	dbgInfo.spritePicked.tableId = GetSpritePatternTableId();
+	dbgInfo.spritePicked.secondaryOamIndex = 0;
 
-		if ( DrawSpritePixel( *fb, attribs, beam, bgPixel & 0x03 ) ) {
+	if ( spriteBucketsDirty ) {
+		BuildSpriteBuckets();
+	}
+
+	for ( uint8_t bucketIx = 0; bucketIx < spriteBucketCount[ line ]; ++bucketIx )
+	{
+		if ( spriteBuckets[ line ][ bucketIx ] == oamIndex ) {
+			dbgInfo.spritePicked.secondaryOamIndex = bucketIx;
 			break;
 		}
 	}
+}
 
-	++beam.index;
+
+bool PPU::CanRenderScanline( const ppuCycle_t& nextCycle ) const
+{
+	// Register reads/writes, OAM DMA and mapper bank writes all catch the PPU up to the CPU before
+	// they take effect, so none can land inside a step. A step that covers a whole visible line
+	// therefore sees no PPU state change, CHR switch or sprite 0 poll until the line is finished.
+	if ( currentScanline >= POSTRENDER_SCANLINE ) {
+		return false;
+	}
+
+	if ( ( cycle.count() % ScanlineCycles ) != 0 ) {
+		return false;
+	}
+
+	return !( nextCycle < ( cycle + ppuCycle_t( ScanlineCycles ) ) );
 }
 
 
-ppuCycle_t PPU::Exec()
+ppuCycle_t PPU::RenderScanline()
 {
-	ppuCycle_t execCycles = ppuCycle_t( 0 );
+	// Equivalent to calling Exec() for dots [0, 340] of a visible scanline
+	UpdateRegisterLatches();
 
-	// Cycle timing
-	const uint64_t cycleCount = cycle.count() % ScanlineCycles;
+	LoadSecondaryOAM();
+	BeginScanlineOutput();
+
+	const uint8_t line = beam.point.y;
+	wtDisplayImage* fb = system->GetBackbuffer();
+	wtIndexedDisplayImage* indexedFb = system->GetIndexedBackbuffer();
+
+	const bool showBg = regMask.sem.showBg && system->GetConfig()->ppu.showBG;
+	const bool showSprites = regMask.sem.showSprt && ( secondaryOamSpriteCnt > 0 );
+
+	compositeGroup_t group;
+	group.showSprites = system->GetConfig()->ppu.showSprite;
+	bool spriteHit = false;
+
+	// The 16 pixels held by the shift registers, one byte per pixel with the palette in bits 2-3
+	uint64_t bgWindow[ 2 ];
+	bgWindow[ 0 ] = DecodeChrRow( chrShifts[ 0 ] >> 8, chrShifts[ 1 ] >> 8, false );
+	bgWindow[ 0 ] |= DecodeChrRow( palShifts[ 0 ], palShifts[ 1 ], false ) << 2;
+	bgWindow[ 1 ] = DecodeChrRow( chrShifts[ 0 ] & 0xFF, chrShifts[ 1 ] & 0xFF, false );
+	bgWindow[ 1 ] |= ( ( palLatch[ 0 ] & 0x1 ) | ( ( palLatch[ 1 ] & 0x1 ) << 1 ) ) * 0x0404040404040404ull;
 
+	const uint32_t fineX = 8 * static_cast<uint32_t>( regX );
+
+	// Dots [1, 256], eight pixels are read from the window and then the next tile is shifted in
+	for ( uint32_t tileX = 0; tileX < NameTableWidthTiles; ++tileX )
+	{
+		uint64_t bgPixels = 0;
+		if ( showBg && ( regMask.sem.bgLeft || ( tileX > 0 ) ) ) {
+			bgPixels = ( fineX == 0 ) ? bgWindow[ 0 ] : ( ( bgWindow[ 0 ] >> fineX ) | ( bgWindow[ 1 ] << ( 64 - fineX ) ) );
+		}
+
+		// The sprite line buffer is already resolved, so it goes in as a single sprite row
+		group.bgPixels = bgPixels;
+		group.sprCount = 0;
+
+		if ( showSprites && ( regMask.sem.sprtLeft || ( tileX > 0 ) ) )
+		{
+			memcpy( &group.sprPixels[ 0 ], &spriteLine[ tileX * TilePixels ], sizeof( uint64_t ) );
+			group.sprCount = 1;
+		}
+
+		if ( indexedOutput ) {
+			spriteHit |= CompositeIndexedPixels( indexedFb->GetRawBuffer() + beam.index, group, resolvedIndices );
+		} else {
+			spriteHit |= CompositePixels( fb->GetRawBuffer() + beam.index, group, resolvedColors );
+		}
+		beam.index += TilePixels;
+
+		bgPixels &= 0x0303030303030303ull;
+		memcpy( &bgLine[ tileX * TilePixels ], &bgPixels, sizeof( uint64_t ) );
+
+		bgWindow[ 0 ] = bgWindow[ 1 ];
+		bgWindow[ 1 ] = BgPipelineFetchTile();
+	}
+
+	if ( spriteHit ) {
+		regStatus.current.sem.spriteHit = true;
+	}
+
+	if ( spriteIdOutput ) {
+		OutputSpriteIdLine( line );
+	}
+
+	if ( RenderEnabled() )
+	{
+		// Dot 257
+		AdvanceYScroll();
+
+		regV.sem.coarseX = regT.sem.coarseX;
+		regV.sem.ntId = ( regV.sem.ntId & 0x2 ) | ( regT.sem.ntId & 0x1 );
+
+		// Dot 260
+		system->cart->mapper->Clock();
+
+		// Dots [321, 336]
+		BgPipelineFetchTile();
+		BgPipelineFetchTile();
+	}
+
+	// Dot 340
+	currentScanline = ( currentScanline + 1 ) % PRERENDER_SCANLINE;
+
+	return ppuCycle_t( ScanlineCycles );
+}
+
+
+FORCE_INLINE void PPU::UpdateRegisterLatches()
+{
 	if ( regStatus.hasLatch )
 	{
 		regStatus.current = regStatus.latched;
@@ -1005,6 +1462,17 @@ ppuCycle_t PPU::Exec()
 		IncRenderAddr();
 		vramAccessed = false;
 	}
+}
+
+
+ppuCycle_t PPU::Exec()
+{
+	ppuCycle_t execCycles = ppuCycle_t( 0 );
+
+	// Cycle timing
+	const uint64_t cycleCount = cycle.count() % ScanlineCycles;
+
+	UpdateRegisterLatches();
 
 	///////////////////////////////////////////////////////////////////////////
 	//                                                                       //
@@ -1087,6 +1555,7 @@ ppuCycle_t PPU::Exec()
 		{
 			if ( cycleCount == 1 ) {
 				LoadSecondaryOAM();
+				BeginScanlineOutput();
 			}
 
 			Render();
@@ -1099,6 +1568,11 @@ ppuCycle_t PPU::Exec()
 	}
 	else if ( cycleCount == 257 )
 	{
+		// Dot 256 moved the beam onto the next line
+		if ( spriteIdOutput && ( currentScanline < POSTRENDER_SCANLINE ) ) {
+			OutputSpriteIdLine( beam.point.y - 1 );
+		}
+
 		if ( RenderEnabled() )
 		{
 			AdvanceYScroll(); // technically done on 256
@@ -1164,6 +1638,13 @@ bool PPU::Step( const ppuCycle_t& nextCycle )
 
 	while ( cycle < nextCycle )
 	{
+#if PPU_SCANLINE_RENDER
+		if ( CanRenderScanline( nextCycle ) )
+		{
+			cycle += RenderScanline();
+			continue;
+		}
+#endif
 		cycle += Exec();
 	}
 
@@ -1,5 +1,7 @@
 #pragma once
+#include <atomic>
 #include "cart.h"
+#include "debug.h"
 
 union Pixel;
 struct RGBA;
@@ -155,6 +157,14 @@ struct pipelineData_t
 };
 
 
+struct chrTile_t
+{
+	uint64_t	rows[ 8 ];			// 2-bit palette index per byte, leftmost pixel in the low byte
+	uint64_t	flippedRows[ 8 ];	// Horizontally mirrored rows for sprites
+	uint8_t		planes[ 2 ][ 8 ];	// Source bit planes as the pipeline fetches them
+};
+
+
 enum ppuScanLine_t
 {
 	POSTRENDER_SCANLINE	= 240,
@@ -204,6 +214,7 @@ public:
 	static const uint16_t SpritePaletteAddr			= 0x3F10;
 	static const uint16_t TotalSprites				= 64;
 	static const uint16_t SecondarySprites			= 8;
+	static const uint8_t NoSpriteId					= 0xFF; // Sprite ID buffer value where no sprite is drawn
 	static const uint32_t NameTableWidthTiles		= 32;
 	static const uint32_t NameTableHeightTiles		= 30;
 	static const uint32_t AttribTableWidthTiles		= 8;
@@ -220,6 +231,14 @@ public:
 	static const uint32_t ScanlineCycles			= 341;
 	static const uint32_t ScreenWidth				= 256;
 	static const uint32_t ScreenHeight				= 240;
+	static const uint32_t ChrTileBytes				= 16;
+	static const uint32_t ChrTileCount				= PatternTableMemorySize / ChrTileBytes;
+	static const uint32_t TilesPerPatternTable		= ChrTileCount / 2;
+	static const uint32_t VramPageSize				= 0x0400;
+	static const uint32_t VramPageCount				= PhysicalMemorySize / VramPageSize;
+	static const uint32_t ChrPageCount				= PatternTableMemorySize / VramPageSize;
+	static const uint32_t PaletteCacheSize			= PaletteSetNumber * PaletteColorNumber;
+	static const uint32_t EmphasisAttenuation		= 209; // Out of 256, applied to the channels an emphasis bit doesn't name
 	//static const ppuCycle_t VBlankCycles = ppuCycle_t( 20 * 341 * 5 );
 
 	ppuDebug_t		dbgInfo;
@@ -252,11 +271,18 @@ private:
 	uint16_t		regX;
 	uint16_t		regW;
 
-	uint32_t		debugVramWriteCounter[VirtualMemorySize];
 	uint8_t			primaryOAM[OamSize];
 	spriteAttrib_t	secondaryOAM[OamSize];
 	uint8_t			secondaryOamSpriteCnt;
 
+	uint8_t			spriteBuckets[ScreenHeight][TotalSprites]; // OAM indices on each line in OAM order
+	uint8_t			spriteBucketCount[ScreenHeight];
+	bool			spriteBucketsDirty;
+	uint8_t			spriteLine[ScreenWidth + TilePixels]; // Current line's sprite pixels, see ppu_composite.h
+	uint8_t			bgLine[ScreenWidth]; // Current line's background pixels, read back by the sprite ID pass
+	bool			indexedOutput; // Latched from the config at the start of each line
+	bool			spriteIdOutput; // Latched from the config at the start of each line
+
 	uint8_t			ppuReadBuffer;
 
 	bool			inVBlank; // This is for internal state tracking not for reporting to the CPU
@@ -272,7 +298,28 @@ private:
 	uint16_t		attrib;
 
 	uint8_t			registers[9]; // no need?
-	uint16_t		MirrorMap[MIRROR_MODE_COUNT][VirtualMemorySize];
+
+	uint8_t*		vramReadPages[VramPageCount];	// 1KB CHR and nametable slots, $3F00 and up is palette RAM
+	uint8_t*		vramWritePages[VramPageCount];	// nullptr where the slot is read only
+	uint8_t			unmappedPage[VramPageSize];		// Read by CHR slots the mapper hasn't mapped
+
+	uint8_t			resolvedIndices[PaletteCacheSize];	// Palette RAM with the backdrop and greyscale folded in
+	uint32_t		resolvedColors[PaletteCacheSize];	// resolvedIndices as pixels with the emphasis applied
+	uint32_t		emphasizedColors[64];				// palette with the current emphasis applied
+
+	chrTile_t		chrTileCache[ChrTileCount]; // Decoded tiles of the current $0000-$1FFF pattern window
+	bool			chrTileValid[ChrTileCount];
+
+	wtVramHeatmap*	vramHeatmap; // Debug instrumentation, nullptr unless the debugger attached one
+
+	// Changes since the debug views were last drawn, so only the affected 8x8 cells are redrawn.
+	// The emulator thread sets these while the debug worker draws, so the worker takes them with an exchange.
+	std::atomic<bool>	ntViewDirty[KB(2)];				// Nametable and attribute bytes of nt
+	std::atomic<bool>	ntViewChrDirty[ChrTileCount];
+	std::atomic<bool>	ntViewStale;					// Palette, mirroring or pattern table changed, redraw everything
+	uint8_t				ntViewPatternTable;
+	std::atomic<bool>	patternViewChrDirty[ChrTileCount];
+	std::atomic<bool>	patternViewStale[2];
 
 public:
 	void			IssueDMA( const uint8_t value );
@@ -284,12 +331,21 @@ public:
 	void			DrawDebugObject( wtRawImageInterface* imageBuffer, const RGBA dbgPalette[ 4 ], const spriteAttrib_t& attrib );
 	void			DrawDebugNametable( wtNameTableImage& nameTableSheet );
 	void			DrawDebugPalette( wtPaletteImage& imageBuffer );
+	void			PickSprite( const uint8_t oamIndex, const uint8_t line );
+	RGBA			GetResolvedColor( const uint8_t paletteIx ) const;
+	static RGBA		EmphasizeColor( const RGBA& color, const uint8_t emphasis );
 
 	void			WriteVram();
 	uint8_t			ReadVram( const uint16_t addr );
 	bool			IsMemoryMapped( const uint16_t addr ) const;
 	ppuCycle_t		GetCycle() const;
 	uint32_t		GetScanline() const;
+	ppuCycle_t		NextSyncCycle( syncEvent_t& event ) const;
+	ppuCycle_t		NextVblankCycle() const;
+	void			InvalidateChrCache( const uint16_t addr, const uint32_t size );
+	void			MapChrMemory( const uint16_t addr, const uint32_t size, uint8_t* readPtr, uint8_t* writePtr );
+	void			MapNameTables( const uint8_t mirrorMode );
+	void			AttachVramHeatmap( wtVramHeatmap* heatmap );
 
 	ppuCycle_t		Exec();
 	bool			Step( const ppuCycle_t& nextCycle );	
@@ -297,8 +353,8 @@ public:
 	PPU()
 	{
 		palette = &DefaultPalette[0];
+		vramHeatmap = nullptr;
 		Reset();
-		GenerateMirrorMap();
 	}
 
 	void Reset()
@@ -344,10 +400,26 @@ public:
 		regStatus.hasLatch		= false;
 
 		memset( secondaryOAM, 0, sizeof( secondaryOAM ) );
+		memset( spriteLine, 0, sizeof( spriteLine ) );
+		spriteBucketsDirty		= true;
+		indexedOutput			= false;
+		spriteIdOutput			= false;
+		memset( bgLine, 0, sizeof( bgLine ) );
 		memset( nt, 0, KB(2) );
 		memset( imgPal, 0, PPU::PaletteColorNumber );
 		memset( sprPal, 0, PPU::PaletteColorNumber );
-		memset( debugVramWriteCounter, 0, VirtualMemorySize );
+		memset( chrTileValid, 0, ChrTileCount );
+
+		memset( unmappedPage, 0, VramPageSize );
+		MapChrMemory( 0x0000, PatternTableMemorySize, nullptr, nullptr );
+		MapNameTables( MIRROR_MODE_HORIZONTAL );
+		RefreshPaletteCache();
+
+		TakeDebugFlags( ntViewDirty, nullptr, KB(2) );
+		TakeDebugFlags( ntViewChrDirty, nullptr, ChrTileCount );
+		TakeDebugFlags( patternViewChrDirty, nullptr, ChrTileCount );
+		ntViewPatternTable = 0;
+		MarkDebugViewsStale();
 	}
 
 	void			Begin();
@@ -358,26 +430,41 @@ public:
 
 private:
 	static uint8_t	GetChrRomPalette( const uint8_t plane0, const uint8_t plane1, const uint8_t col );
+	static uint64_t	DecodeChrRow( const uint8_t plane0, const uint8_t plane1, const bool flipped );
 
 	uint8_t			GetChrRom8x8( const uint32_t tileId, const uint8_t plane, const uint8_t ptrnTableId, const uint8_t row );
 	uint8_t			GetChrRom8x16( const uint32_t tileId, const uint8_t plane, const uint8_t row, const uint8_t isUpper );
 	uint8_t			GetChrRomBank8x8( const uint32_t tileId, const uint8_t plane, const uint8_t bankId, const uint8_t row );
+	const chrTile_t&	GetChrTile( const uint16_t chrAddr );
+	const chrTile_t&	GetChrTile8x8( const uint32_t tileId, const uint8_t ptrnTableId );
+	const chrTile_t&	GetChrTile8x16( const uint32_t tileId, const uint8_t isUpper );
+	void			DecodeChrTile( const uint32_t tileIx );
 
 	void			DrawBlankScanline( wtDisplayImage& imageBuffer, const wtRect& imageRect, const uint8_t scanY );
 	void			DrawTile( wtNameTableImage& imageBuffer, const wtRect& imageRect, const wtPoint& nametableTile, const uint32_t ntId, const uint32_t ptrnTableId );
 	void			DrawChrRomTile( wtRawImageInterface* imageBuffer, const wtRect& imageRect, const RGBA palette[4], const uint32_t tileId, const uint32_t tableId, const bool cartBank, const bool is8x16 = false, const bool isUpper = false );
-	bool			DrawSpritePixel( wtDisplayImage& fb, const spriteAttrib_t attribs, const ppuImageIx_t& index, const uint8_t bgPixel );
+	uint64_t		GetSpriteChrRow( const spriteAttrib_t& attribs, const int32_t spriteY );
+	void			DrawSprites( const uint8_t bgPixel );
+	void			BeginScanlineOutput();
+	void			OutputPixel( const uint32_t imageIx, const uint8_t paletteIx );
+	void			OutputSpriteIdLine( const uint8_t line );
 
 	bool			BgDataFetchEnabled();
 	void			BgPipelineShiftRegisters();
 	void			BgPipelineDebugPrefetchFetchTiles();
 	uint8_t			BgPipelineDecodePalette();
 	void			BgPipelineFetch( const uint64_t cycle );
+	uint64_t		BgPipelineFetchTile();
 	void			AdvanceXScroll();
 	void			AdvanceYScroll();
 	void			LoadSecondaryOAM();
+	void			BuildSpriteBuckets();
+	void			RasterizeSpriteLine();
 	void			DMA( const uint16_t address );
 	void			Render();
+	bool			CanRenderScanline( const ppuCycle_t& nextCycle ) const;
+	ppuCycle_t		RenderScanline();
+	void			UpdateRegisterLatches();
 	spriteAttrib_t	GetSpriteData( const uint8_t spriteId, const uint8_t oam[] );
 
 	uint8_t			GetBgPatternTableId();
@@ -387,11 +474,16 @@ private:
 	uint8_t			GetArribute( const uint32_t ntId, const wtPoint& tileCoord );
 	uint8_t			GetTilePaletteId( const uint32_t attribTable, const wtPoint& tileCoord );
 
-	uint16_t		StaticMirrorVram( uint16_t addr, uint32_t mirrorMode );
-	uint16_t		MirrorVram( uint16_t addr );
-	void			GenerateMirrorMap();
+	uint8_t			PaletteIndex( const uint16_t addr );
+	uint8_t&		PaletteEntry( const uint16_t addr );
+	void			ResolvePaletteEntry( const uint8_t paletteIx );
+	void			RefreshPaletteCache();
+	void			MarkDebugViewsStale();
+	static void		TakeDebugFlags( std::atomic<bool>* flags, bool* taken, const uint32_t count );
+	void			UpdatePaletteCache( const uint8_t paletteIx );
 
 	bool			RenderEnabled();
+	ppuCycle_t		CycleAtScanline( const int32_t scanline, const uint32_t dot ) const;
 	bool			DataportEnabled();
 	bool			InVBlank();
 	void			IncRenderAddr();
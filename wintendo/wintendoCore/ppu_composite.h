@@ -0,0 +1,197 @@
+#pragma once
+
+#include <stdint.h>
+#include "common.h"
+
+#include <emmintrin.h>
+#if PPU_COMPOSITE_SIMD == 2
+#include <immintrin.h>
+#endif
+
+// 8-pixel background and sprite compositing for the scanline renderer.
+// Pixels are packed one per byte in a uint64_t with the leftmost pixel in the low byte:
+//	bits 0-1: color
+//	bits 2-3: palette
+//	bit 4:    sprite palette, set on every sprite byte
+//	bit 5:    sprite is behind the background
+//	bit 6:    sprite 0
+// Background bytes are 0 where the background is hidden. Sprite rows are in OAM order and
+// the first opaque sprite byte wins. The 32 entry color table holds the background palette
+// followed by the sprite palette. It holds 32-bit pixels, or palette indices for the indexed
+// frame buffer which ExpandIndexedPixels turns into pixels later.
+
+static const uint8_t CompositeSpritePalette	= 0x10;
+static const uint8_t CompositeSpriteBehind	= 0x20;
+static const uint8_t CompositeSprite0		= 0x40;
+static const uint8_t CompositeColorMask		= 0x1F;
+
+struct compositeGroup_t
+{
+	uint64_t	bgPixels;
+	uint64_t	sprPixels[ 8 ];
+	uint32_t	sprCount;
+	bool		showSprites; // When false sprites still block each other and set sprite 0 hit but aren't drawn
+};
+
+
+// Reference implementation, the SIMD kernels must match it bit for bit
+template< typename ColorType >
+inline bool CompositePixelsScalar( ColorType dest[ 8 ], const compositeGroup_t& group, const ColorType colors[ 32 ] )
+{
+	bool spriteHit = false;
+	for ( uint32_t pixelX = 0; pixelX < 8; ++pixelX )
+	{
+		const uint8_t bgPixel = static_cast<uint8_t>( group.bgPixels >> ( 8 * pixelX ) );
+
+		uint8_t sprPixel = 0;
+		for ( uint32_t spriteIx = 0; spriteIx < group.sprCount; ++spriteIx )
+		{
+			const uint8_t pixel = static_cast<uint8_t>( group.sprPixels[ spriteIx ] >> ( 8 * pixelX ) );
+			if ( ( pixel & 0x03 ) != 0 )
+			{
+				sprPixel = pixel;
+				break;
+			}
+		}
+
+		const bool bgOpaque = ( bgPixel & 0x03 ) != 0;
+		const bool sprOpaque = ( sprPixel & 0x03 ) != 0;
+
+		if ( ( sprPixel & CompositeSprite0 ) && bgOpaque ) {
+			spriteHit = true;
+		}
+
+		const bool behind = ( sprPixel & CompositeSpriteBehind ) && bgOpaque;
+		const bool useSprite = sprOpaque && !behind && group.showSprites;
+
+		dest[ pixelX ] = colors[ useSprite ? ( sprPixel & CompositeColorMask ) : bgPixel ];
+	}
+	return spriteHit;
+}
+
+
+// Resolves the 8 color indices in the low half of the register, returns the sprite 0 hit
+FORCE_INLINE bool CompositeIndicesSSE2( const compositeGroup_t& group, __m128i& indices )
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i colorBits = _mm_set1_epi8( 0x03 );
+
+	// Walk the sprites back to front so the first opaque one is left
+	__m128i sprPixels = zero;
+	for ( int32_t spriteIx = static_cast<int32_t>( group.sprCount ) - 1; spriteIx >= 0; --spriteIx )
+	{
+		const __m128i pixels = _mm_loadl_epi64( reinterpret_cast<const __m128i*>( &group.sprPixels[ spriteIx ] ) );
+		const __m128i clear = _mm_cmpeq_epi8( _mm_and_si128( pixels, colorBits ), zero );
+		sprPixels = _mm_or_si128( _mm_and_si128( clear, sprPixels ), _mm_andnot_si128( clear, pixels ) );
+	}
+
+	const __m128i bgPixels = _mm_loadl_epi64( reinterpret_cast<const __m128i*>( &group.bgPixels ) );
+	const __m128i bgClear = _mm_cmpeq_epi8( _mm_and_si128( bgPixels, colorBits ), zero );
+	const __m128i sprClear = _mm_cmpeq_epi8( _mm_and_si128( sprPixels, colorBits ), zero );
+
+	const __m128i sprite0 = _mm_cmpeq_epi8( _mm_and_si128( sprPixels, _mm_set1_epi8( CompositeSprite0 ) ), zero );
+	const bool spriteHit = ( _mm_movemask_epi8( _mm_or_si128( sprite0, bgClear ) ) & 0xFF ) != 0xFF;
+
+	// Draw the sprite where it is opaque and either in front or over a clear background
+	const __m128i inFront = _mm_cmpeq_epi8( _mm_and_si128( sprPixels, _mm_set1_epi8( CompositeSpriteBehind ) ), zero );
+	__m128i useSprite = _mm_andnot_si128( sprClear, _mm_or_si128( inFront, bgClear ) );
+	if ( !group.showSprites ) {
+		useSprite = zero;
+	}
+
+	const __m128i sprColors = _mm_and_si128( sprPixels, _mm_set1_epi8( CompositeColorMask ) );
+	indices = _mm_or_si128( _mm_and_si128( useSprite, sprColors ), _mm_andnot_si128( useSprite, bgPixels ) );
+
+	return spriteHit;
+}
+
+
+template< typename ColorType >
+FORCE_INLINE bool CompositePixelsSSE2( ColorType dest[ 8 ], const compositeGroup_t& group, const ColorType colors[ 32 ] )
+{
+	__m128i indices;
+	const bool spriteHit = CompositeIndicesSSE2( group, indices );
+
+	// SSE2 has no gather, the palette lookup stays scalar
+	uint64_t colorIndices;
+	_mm_storel_epi64( reinterpret_cast<__m128i*>( &colorIndices ), indices );
+	for ( uint32_t pixelX = 0; pixelX < 8; ++pixelX ) {
+		dest[ pixelX ] = colors[ ( colorIndices >> ( 8 * pixelX ) ) & 0xFF ];
+	}
+
+	return spriteHit;
+}
+
+
+#if PPU_COMPOSITE_SIMD == 2
+FORCE_INLINE bool CompositePixelsAVX2( uint32_t dest[ 8 ], const compositeGroup_t& group, const uint32_t colors[ 32 ] )
+{
+	__m128i indices;
+	const bool spriteHit = CompositeIndicesSSE2( group, indices );
+
+	const __m256i rgba = _mm256_i32gather_epi32( reinterpret_cast<const int*>( colors ), _mm256_cvtepu8_epi32( indices ), 4 );
+	_mm256_storeu_si256( reinterpret_cast<__m256i*>( dest ), rgba );
+
+	return spriteHit;
+}
+#endif
+
+
+FORCE_INLINE bool CompositePixels( uint32_t dest[ 8 ], const compositeGroup_t& group, const uint32_t colors[ 32 ] )
+{
+#if PPU_COMPOSITE_SIMD == 2
+	return CompositePixelsAVX2( dest, group, colors );
+#elif PPU_COMPOSITE_SIMD == 1
+	return CompositePixelsSSE2( dest, group, colors );
+#else
+	return CompositePixelsScalar( dest, group, colors );
+#endif
+}
+
+
+// The indexed frame buffer only needs the color indices so it has no use for a gather
+FORCE_INLINE bool CompositeIndexedPixels( uint8_t dest[ 8 ], const compositeGroup_t& group, const uint8_t colors[ 32 ] )
+{
+#if PPU_COMPOSITE_SIMD >= 1
+	return CompositePixelsSSE2( dest, group, colors );
+#else
+	return CompositePixelsScalar( dest, group, colors );
+#endif
+}
+
+
+inline void ExpandIndexedPixelsScalar( uint32_t* dest, const uint8_t* src, const uint32_t count, const uint32_t colors[ 64 ] )
+{
+	for ( uint32_t pixelIx = 0; pixelIx < count; ++pixelIx ) {
+		dest[ pixelIx ] = colors[ src[ pixelIx ] & 0x3F ];
+	}
+}
+
+
+#if PPU_COMPOSITE_SIMD == 2
+FORCE_INLINE void ExpandIndexedPixelsAVX2( uint32_t* dest, const uint8_t* src, const uint32_t count, const uint32_t colors[ 64 ] )
+{
+	const __m128i indexMask = _mm_set1_epi8( 0x3F );
+
+	uint32_t pixelIx = 0;
+	for ( ; ( pixelIx + 8 ) <= count; pixelIx += 8 )
+	{
+		const __m128i indices = _mm_and_si128( _mm_loadl_epi64( reinterpret_cast<const __m128i*>( src + pixelIx ) ), indexMask );
+		const __m256i pixels = _mm256_i32gather_epi32( reinterpret_cast<const int*>( colors ), _mm256_cvtepu8_epi32( indices ), 4 );
+		_mm256_storeu_si256( reinterpret_cast<__m256i*>( dest + pixelIx ), pixels );
+	}
+
+	ExpandIndexedPixelsScalar( dest + pixelIx, src + pixelIx, count - pixelIx, colors );
+}
+#endif
+
+
+// Resolves palette indices through a 64 entry table already converted to the wanted pixel format
+FORCE_INLINE void ExpandIndexedPixels( uint32_t* dest, const uint8_t* src, const uint32_t count, const uint32_t colors[ 64 ] )
+{
+#if PPU_COMPOSITE_SIMD == 2
+	ExpandIndexedPixelsAVX2( dest, src, count, colors );
+#else
+	ExpandIndexedPixelsScalar( dest, src, count, colors );
+#endif
+}
@@ -70,6 +70,10 @@ void wtSystem::Serialize( Serializer& serializer )
 	ppu.Serialize( serializer );
 	apu.Serialize( serializer );
 	cart->mapper->Serialize( serializer );
+
+	if ( serializer.GetMode() == serializeMode_t::LOAD ) {
+		ppu.InvalidateChrCache( 0x0000, PPU::PatternTableMemorySize );
+	}
 }
 
 
@@ -88,7 +92,11 @@ void Cpu6502::Serialize( Serializer& serializer )
 	serializer.Next8b( Y );
 	serializer.Next8b( A );
 	serializer.Next8b( SP );
-	serializer.Next8b( P.byte );
+	statusReg_t status = GetStatus();
+	serializer.Next8b( status.byte );
+	if ( serializer.GetMode() == serializeMode_t::LOAD ) {
+		SetStatus( status.byte );
+	}
 	serializer.Next16b( PC );
 }
 
@@ -137,6 +145,12 @@ void PPU::Serialize( Serializer& serializer )
 	serializer.NextArray( registers, 9 );
 	serializer.NextArray( reinterpret_cast<uint8_t*>( &plShifts ), 2 * sizeof( pipelineData_t ) );
 	serializer.NextArray( reinterpret_cast<uint8_t*>( &plLatches ), sizeof( pipelineData_t ) );
+
+	if ( serializer.GetMode() == serializeMode_t::LOAD ) {
+		spriteBucketsDirty = true;
+		RefreshPaletteCache();
+		MarkDebugViewsStale();
+	}
 }
 
 
@@ -1,5 +1,6 @@
 #pragma once
 #include <stdint.h>
+#include <atomic>
 #include "assert.h"
 
 template < uint16_t B >
@@ -259,4 +260,110 @@ private:
 	T		samples[ SIZE ];
 	int32_t	begin;
 	int32_t	end;
+};
+
+
+// Lock-free ring for one producer thread and one consumer thread. Indices run freely and
+// wrap with the mask. Padding keeps the producer and consumer fields on separate cache
+// lines without relying on over-aligned allocation.
+template< typename T, uint32_t SIZE >
+class wtSpscRing
+{
+	static_assert( ( SIZE & ( SIZE - 1 ) ) == 0, "Ring size must be a power of two" );
+	static const uint32_t CacheLineSize = 64;
+
+public:
+	wtSpscRing()
+	{
+		head.store( 0 );
+		overrunCnt.store( 0 );
+		tail.store( 0 );
+		underrunCnt.store( 0 );
+		trimCnt.store( 0 );
+	}
+
+	// Producer, samples that don't fit are dropped and counted as an overrun
+	uint32_t Write( const T* src, const uint32_t count )
+	{
+		const uint32_t writeIx = head.load( std::memory_order_relaxed );
+		const uint32_t readIx = tail.load( std::memory_order_acquire );
+		const uint32_t freeCnt = SIZE - ( writeIx - readIx );
+		const uint32_t writeCnt = ( count < freeCnt ) ? count : freeCnt;
+
+		for ( uint32_t i = 0; i < writeCnt; ++i ) {
+			samples[ ( writeIx + i ) & ( SIZE - 1 ) ] = src[ i ];
+		}
+		head.store( writeIx + writeCnt, std::memory_order_release );
+
+		if ( writeCnt < count ) {
+			overrunCnt.store( overrunCnt.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+		}
+		return writeCnt;
+	}
+
+	// Consumer, a read that comes up short is counted as an underrun
+	uint32_t Read( T* dest, const uint32_t count )
+	{
+		const uint32_t readIx = tail.load( std::memory_order_relaxed );
+		const uint32_t writeIx = head.load( std::memory_order_acquire );
+		const uint32_t availCnt = writeIx - readIx;
+		const uint32_t readCnt = ( count < availCnt ) ? count : availCnt;
+
+		for ( uint32_t i = 0; i < readCnt; ++i ) {
+			dest[ i ] = samples[ ( readIx + i ) & ( SIZE - 1 ) ];
+		}
+		tail.store( readIx + readCnt, std::memory_order_release );
+
+		if ( readCnt < count ) {
+			underrunCnt.store( underrunCnt.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+		}
+		return readCnt;
+	}
+
+	// Consumer, drops the oldest samples so at most maxCount stay queued. Counted as an overrun.
+	uint32_t Trim( const uint32_t maxCount )
+	{
+		const uint32_t readIx = tail.load( std::memory_order_relaxed );
+		const uint32_t writeIx = head.load( std::memory_order_acquire );
+		const uint32_t availCnt = writeIx - readIx;
+		if ( availCnt <= maxCount ) {
+			return 0;
+		}
+
+		tail.store( writeIx - maxCount, std::memory_order_release );
+		trimCnt.store( trimCnt.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+		return ( availCnt - maxCount );
+	}
+
+	// Consumer, drops everything queued without counting it
+	void Flush()
+	{
+		tail.store( head.load( std::memory_order_acquire ), std::memory_order_release );
+	}
+
+	uint32_t GetSampleCnt() const
+	{
+		const uint32_t readIx = tail.load( std::memory_order_acquire );
+		return ( head.load( std::memory_order_acquire ) - readIx );
+	}
+
+	uint32_t GetOverrunCnt() const
+	{
+		return overrunCnt.load( std::memory_order_relaxed ) + trimCnt.load( std::memory_order_relaxed );
+	}
+
+	uint32_t GetUnderrunCnt() const
+	{
+		return underrunCnt.load( std::memory_order_relaxed );
+	}
+
+private:
+	std::atomic<uint32_t>	head;			// Written by the producer
+	std::atomic<uint32_t>	overrunCnt;
+	uint8_t					producerPad[ CacheLineSize ];
+	std::atomic<uint32_t>	tail;			// Written by the consumer
+	std::atomic<uint32_t>	underrunCnt;
+	std::atomic<uint32_t>	trimCnt;
+	uint8_t					consumerPad[ CacheLineSize ];
+	T						samples[ SIZE ];
 };
\ No newline at end of file
@@ -4,24 +4,163 @@
 #include <fstream>
 #include <Windows.h>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <wchar.h>
 #include <sstream>
 
 #include "bitmap.h"
 #include "NesSystem.h"
+#include "timer.h"
+#include "ppu_composite.h"
 
 wtSystem nesSystem;
 
-int main()
+// Build once with each CPU_SWITCH_DISPATCH setting to compare the dispatch engines
+static const wchar_t* BenchmarkRoms[] =
+{
+	L"Tests/nestest.nes",
+	L"Tests/color_test.nes",
+	L"Tests/full_palette.nes",
+	L"Tests/full_palette_alt.nes",
+	L"Tests/instr_test-v5/official_only.nes",
+	L"Tests/instr_test-v5/all_instrs.nes",
+};
+static const uint32_t BenchmarkFrames = 600;
+static const uint32_t HistogramFrames = 10;
+static const uint32_t HistogramTopPairs = 24;
+static const uint32_t CompositeTestGroups = 1000000;
+
+// Runs the selected compositing kernel against the scalar reference on random pixel groups.
+// The indexed kernel and expansion are checked to land on the same pixels as the direct path.
+static bool TestCompositeKernel()
 {
-	nesSystem.Init( L"Games/Contra.nes" );
+	uint32_t colors[ 32 ];
+	uint8_t colorIndices[ 32 ];
+	uint32_t paletteColors[ 64 ];
+	for ( uint32_t i = 0; i < 32; ++i ) {
+		colors[ i ] = 0xFF000000 | ( i * 0x00050301 );
+		colorIndices[ i ] = static_cast<uint8_t>( 2 * i );
+		paletteColors[ 2 * i ] = colors[ i ];
+		paletteColors[ 2 * i + 1 ] = 0;
+	}
+
+	uint64_t seed = 0x9E3779B97F4A7C15ull;
+	auto nextRandom = [ &seed ]() {
+		seed ^= seed << 13;
+		seed ^= seed >> 7;
+		seed ^= seed << 17;
+		return seed;
+	};
+
+	uint32_t mismatches = 0;
+	for ( uint32_t groupIx = 0; groupIx < CompositeTestGroups; ++groupIx )
+	{
+		compositeGroup_t group;
+		group.bgPixels = nextRandom() & 0x0F0F0F0F0F0F0F0Full;
+		group.sprCount = nextRandom() % 9;
+		group.showSprites = ( nextRandom() & 0x7 ) != 0;
+		for ( uint32_t spriteIx = 0; spriteIx < 8; ++spriteIx ) {
+			group.sprPixels[ spriteIx ] = ( nextRandom() & 0x6F6F6F6F6F6F6F6Full ) | 0x1010101010101010ull;
+		}
+
+		uint32_t expected[ 8 ];
+		uint32_t actual[ 8 ];
+		const bool expectedHit = CompositePixelsScalar( expected, group, colors );
+		const bool actualHit = CompositePixels( actual, group, colors );
 
+		uint8_t indexed[ 8 ];
+		uint32_t expanded[ 8 ];
+		const bool indexedHit = CompositeIndexedPixels( indexed, group, colorIndices );
+		ExpandIndexedPixels( expanded, indexed, 8, paletteColors );
+
+		if ( ( expectedHit != actualHit ) || ( memcmp( expected, actual, sizeof( expected ) ) != 0 ) ) {
+			++mismatches;
+		}
+		else if ( ( expectedHit != indexedHit ) || ( memcmp( expected, expanded, sizeof( expected ) ) != 0 ) ) {
+			++mismatches;
+		}
+	}
+
+	std::wcout << L"Composite kernel: " << ( PPU_COMPOSITE_SIMD == 2 ? L"AVX2" : ( PPU_COMPOSITE_SIMD == 1 ? L"SSE2" : L"scalar" ) );
+	std::wcout << L", " << mismatches << L" mismatches over " << CompositeTestGroups << L" groups" << std::endl;
+
+	return ( mismatches == 0 );
+}
+
+int main()
+{
 	config_t cfg;
 	wtSystem::InitConfig( cfg );
 	cfg.sys.flags = emulationFlags_t::HEADLESS;
-	nesSystem.SetConfig( cfg );
 
-	nesSystem.RunEpoch( FrameLatencyNs );
+	std::wcout << L"CPU dispatch: " << ( CPU_SWITCH_DISPATCH ? L"switch" : L"opLUT" ) << std::endl;
+
+	if ( !TestCompositeKernel() ) {
+		return 1;
+	}
+
+	double totalMs = 0.0;
+	for ( const wchar_t* romPath : BenchmarkRoms )
+	{
+		nesSystem.Init( romPath );
+		nesSystem.SetConfig( cfg );
+
+		Timer timer;
+		timer.Start();
+		for ( uint32_t frame = 0; frame < BenchmarkFrames; ++frame ) {
+			nesSystem.RunEpoch( FrameLatencyNs );
+		}
+		timer.Stop();
+
+		const double elapsedMs = timer.GetElapsedMs();
+		totalMs += elapsedMs;
+		std::wcout << std::setw( 40 ) << std::left << romPath << std::fixed << std::setprecision( 3 ) << ( elapsedMs / BenchmarkFrames ) << L" ms/frame" << std::endl;
+
+		nesSystem.Shutdown();
+	}
+
+	const uint32_t romCount = sizeof( BenchmarkRoms ) / sizeof( BenchmarkRoms[ 0 ] );
+	std::wcout << std::setw( 40 ) << std::left << L"Average" << std::fixed << std::setprecision( 3 ) << ( totalMs / ( romCount * BenchmarkFrames ) ) << L" ms/frame" << std::endl;
+
+	// Opcode pair counts from the trace log, these pick the instruction pairs the CPU fuses
+	static wtFrameResult frameResult;
+	opPairHistogram_t histogram;
+	for ( const wchar_t* romPath : BenchmarkRoms )
+	{
+		nesSystem.Init( romPath );
+		nesSystem.SetConfig( cfg );
+
+		sysCmd_t traceCmd;
+		traceCmd.type = sysCmdType_t::START_TRACE;
+		traceCmd.parms[ 0 ].u = HistogramFrames;
+		nesSystem.SubmitCommand( traceCmd );
+
+		for ( uint32_t frame = 0; frame <= HistogramFrames; ++frame ) {
+			nesSystem.RunEpoch( FrameLatencyNs );
+		}
+
+		nesSystem.GetFrameResult( frameResult );
+		if ( frameResult.dbgLog != nullptr ) {
+			frameResult.dbgLog->CountOpPairs( histogram, 0, frameResult.dbgLog->GetRecordCount() - 1 );
+		}
+
+		nesSystem.Shutdown();
+	}
+
+	uint64_t pairTotal = 0;
+	std::vector<std::pair<uint16_t, opPairCount_t>> pairs( histogram.begin(), histogram.end() );
+	for ( const auto& pair : pairs ) {
+		pairTotal += pair.second.count;
+	}
+	std::sort( pairs.begin(), pairs.end(), []( const auto& lhs, const auto& rhs ) { return lhs.second.count > rhs.second.count; } );
 
-	nesSystem.Shutdown();
+	std::wcout << std::endl << L"Top opcode pairs over " << HistogramFrames << L" traced frames:" << std::endl;
+	for ( uint32_t i = 0; ( i < HistogramTopPairs ) && ( i < pairs.size() ); ++i )
+	{
+		const opPairCount_t& pair = pairs[ i ].second;
+		std::wcout << std::hex << std::uppercase << std::setfill( L'0' ) << std::setw( 2 ) << ( pairs[ i ].first >> 8 ) << L" " << std::setw( 2 ) << ( pairs[ i ].first & 0xFF );
+		std::wcout << std::dec << std::setfill( L' ' ) << L"  " << pair.first << L" " << pair.second << L"\t" << pair.count;
+		std::wcout << std::fixed << std::setprecision( 2 ) << L"\t" << ( 100.0 * pair.count / pairTotal ) << L"%" << std::endl;
+	}
 }
\ No newline at end of file